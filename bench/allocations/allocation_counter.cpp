@@ -0,0 +1,40 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Kept in its own translation unit so the replaced operators are
+// never inlined next to the code that uses them
+namespace
+{
+	std::atomic<std::size_t> allocation_count{ 0 };
+}
+
+void* operator new(std::size_t size)
+{
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (void* pointer = std::malloc(size == 0 ? 1 : size))
+	{
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+namespace bench
+{
+	std::size_t AllocationCount()
+	{
+		return allocation_count.load(std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+namespace bench
+{
+	// Number of calls to the global operator new since the start of the
+	// program. The operator is only replaced in the allocation benchmark
+	// executable, so the other benchmarks run with the default allocator.
+	std::size_t AllocationCount();
+}
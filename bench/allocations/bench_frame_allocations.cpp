@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "raytracing/ray_tracer.h"
+
+namespace raytracing
+{
+	// Same random scene as the ray tracer benchmarks: 100 spheres
+	// in front of the camera, each with its own random material
+	void SetRandomScene(Raytracer& raytracer)
+	{
+		constexpr std::size_t count = 100;
+		std::mt19937 generator(42);
+		const float half_size = 2.0f * std::cbrt(static_cast<float>(count));
+		std::uniform_real_distribution<float> position(-half_size, half_size);
+		std::uniform_real_distribution<float> color(0.0f, 255.0f);
+
+		std::vector<maths::Sphere> spheres;
+		std::vector<Material> materials;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			maths::Sphere sphere(0.5f, maths::Vector3f(
+				position(generator), position(generator), position(generator) - 2.0f * half_size));
+			sphere.set_material_index(static_cast<std::uint32_t>(i));
+			spheres.push_back(sphere);
+			materials.push_back(Material(0.2f,
+				maths::Vector3f(color(generator), color(generator), color(generator))));
+		}
+		raytracer.SetScene(spheres, std::vector<maths::Plane>(), materials,
+			PointLight(), 180, 320, 51.52f, 1e-4);
+		raytracer.set_thread_count(1);
+	}
+
+	// Frame read back as a vector, like the previous by value frameBuffer()
+	static void BM_FrameCopy(benchmark::State& state)
+	{
+		//Setup
+		Raytracer raytracer;
+		SetRandomScene(raytracer);
+		raytracer.Render();
+
+		const std::size_t allocations_before = bench::AllocationCount();
+		for (auto _ : state)
+		{
+			raytracer.Render();
+			std::vector<maths::Vector3f> frame(raytracer.frameBuffer().begin(), raytracer.frameBuffer().end());
+			benchmark::DoNotOptimize(frame.data());
+		}
+		state.counters["allocations_per_frame"] = benchmark::Counter(
+			static_cast<double>(bench::AllocationCount() - allocations_before), benchmark::Counter::kAvgIterations);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_FrameCopy)->Unit(benchmark::kMillisecond);
+
+	// Frame rendered straight into a buffer owned by the caller
+	static void BM_FrameRenderInto(benchmark::State& state)
+	{
+		//Setup
+		Raytracer raytracer;
+		SetRandomScene(raytracer);
+		std::vector<maths::Vector3f> frame(320 * 180);
+		raytracer.RenderInto(frame);
+
+		const std::size_t allocations_before = bench::AllocationCount();
+		for (auto _ : state)
+		{
+			raytracer.RenderInto(frame);
+			benchmark::DoNotOptimize(frame.data());
+		}
+		state.counters["allocations_per_frame"] = benchmark::Counter(
+			static_cast<double>(bench::AllocationCount() - allocations_before), benchmark::Counter::kAvgIterations);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_FrameRenderInto)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,381 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "paths/path.h"
+#include "paths/inverted_priority_queue.h"
+
+namespace path
+{
+	// Grid of size * size nodes linked to their four neighbors
+	std::vector<Node> CreateGrid(int size)
+	{
+		std::vector<Node> nodes;
+		nodes.reserve(static_cast<std::size_t>(size) * size);
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				std::vector<NodeIndex> neighbors;
+				if (x > 0) neighbors.push_back(y * size + x - 1);
+				if (x < size - 1) neighbors.push_back(y * size + x + 1);
+				if (y > 0) neighbors.push_back((y - 1) * size + x);
+				if (y < size - 1) neighbors.push_back((y + 1) * size + x);
+				nodes.push_back(Node(maths::Vector2f(static_cast<float>(x), static_cast<float>(y)), neighbors));
+			}
+		}
+		return nodes;
+	}
+
+	// Start and end nodes picked at random on the grid
+	std::vector<std::pair<NodeIndex, NodeIndex>> CreateQueries(int size, std::size_t count)
+	{
+		std::mt19937 generator(5);
+		std::uniform_int_distribution<NodeIndex> node(0, static_cast<NodeIndex>(size * size - 1));
+		std::vector<std::pair<NodeIndex, NodeIndex>> queries(count);
+		for (auto& query : queries)
+		{
+			query = { node(generator), node(generator) };
+		}
+		return queries;
+	}
+
+	float Distance(const Node& a, const Node& b)
+	{
+		return maths::Vector2f{ a.position().x - b.position().x, a.position().y - b.position().y }.Magnitude();
+	}
+
+	// Previous A*, keeping its state in maps. The maps start empty for
+	// each query, the costs of a previous query would cut the search.
+	std::vector<NodeIndex> FindPathWithMaps(const std::vector<Node>& graph, NodeIndex start_node, NodeIndex end_node)
+	{
+		std::map<NodeIndex, NodeIndex> came_from;
+		std::map<NodeIndex, float> cost_so_far;
+		PriorityQueue<NodeIndex, float> frontier;
+		frontier.put(start_node, 0.0f);
+		came_from[start_node] = start_node;
+		cost_so_far[start_node] = 0.0f;
+		NodeIndex current = start_node;
+		while (!frontier.empty())
+		{
+			current = frontier.get();
+			if (current == end_node)
+			{
+				break;
+			}
+			for (NodeIndex next : graph[current].neighbors())
+			{
+				const float new_cost = cost_so_far[current] + Distance(graph[current], graph[next]);
+				if (cost_so_far.find(next) == cost_so_far.end() || new_cost < cost_so_far[next])
+				{
+					cost_so_far[next] = new_cost;
+					frontier.put(next, new_cost + Distance(graph[next], graph[end_node]));
+					came_from[next] = current;
+				}
+			}
+		}
+		std::vector<NodeIndex> path;
+		if (current != end_node)
+		{
+			return path;
+		}
+		path.push_back(current);
+		while (current != start_node)
+		{
+			current = came_from[current];
+			path.push_back(current);
+		}
+		return { path.rbegin(), path.rend() };
+	}
+
+	static void BM_FindPathMaps(benchmark::State& state)
+	{
+		//Setup
+		const int size = static_cast<int>(state.range(0));
+		const std::vector<Node> graph = CreateGrid(size);
+		const auto queries = CreateQueries(size, 64);
+
+		std::size_t query_index = 0;
+		for (auto _ : state)
+		{
+			const auto& [start, end] = queries[query_index++ % queries.size()];
+			benchmark::DoNotOptimize(FindPathWithMaps(graph, start, end));
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_FindPathMaps)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+	static void BM_FindPathArrays(benchmark::State& state)
+	{
+		//Setup
+		const int size = static_cast<int>(state.range(0));
+		Map map;
+		for (const Node& node : CreateGrid(size))
+		{
+			map.AddNode(node);
+		}
+		const auto queries = CreateQueries(size, 64);
+
+		std::size_t query_index = 0;
+		for (auto _ : state)
+		{
+			const auto& [start, end] = queries[query_index++ % queries.size()];
+			benchmark::DoNotOptimize(map.FindPath(start, end));
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_FindPathArrays)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+	// Same queries with each heuristic, the Manhattan distance being exact
+	// on the grid
+	template<typename Heuristic>
+	static void BM_FindPathHeuristic(benchmark::State& state)
+	{
+		//Setup
+		const int size = static_cast<int>(state.range(0));
+		Map map;
+		for (const Node& node : CreateGrid(size))
+		{
+			map.AddNode(node);
+		}
+		const auto queries = CreateQueries(size, 64);
+
+		std::size_t query_index = 0;
+		for (auto _ : state)
+		{
+			const auto& [start, end] = queries[query_index++ % queries.size()];
+			benchmark::DoNotOptimize(map.FindPath(start, end, Heuristic()));
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	// Register the function as a benchmark
+	BENCHMARK_TEMPLATE(BM_FindPathHeuristic, EuclideanHeuristic)->Arg(1000)->Unit(benchmark::kMillisecond);
+	BENCHMARK_TEMPLATE(BM_FindPathHeuristic, ManhattanHeuristic)->Arg(1000)->Unit(benchmark::kMillisecond);
+	BENCHMARK_TEMPLATE(BM_FindPathHeuristic, OctileHeuristic)->Arg(1000)->Unit(benchmark::kMillisecond);
+	BENCHMARK_TEMPLATE(BM_FindPathHeuristic, ZeroHeuristic)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+	// Previous layout of the graph, one Node and one neighbor vector per node
+	static void BM_GraphBuildNodes(benchmark::State& state)
+	{
+		const int size = static_cast<int>(state.range(0));
+		for (auto _ : state)
+		{
+			std::vector<Node> graph = CreateGrid(size);
+			benchmark::DoNotOptimize(graph.data());
+		}
+		state.SetItemsProcessed(state.iterations() * size * size);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_GraphBuildNodes)->Arg(1000)->Arg(2237)->Unit(benchmark::kMillisecond);
+
+	// Same grid added to the compressed rows of a map
+	static void BM_GraphBuildRows(benchmark::State& state)
+	{
+		const int size = static_cast<int>(state.range(0));
+		for (auto _ : state)
+		{
+			Map map;
+			map.Reserve(static_cast<std::size_t>(size) * size, 4 * static_cast<std::size_t>(size) * size);
+			NodeIndex neighbors[4];
+			for (int y = 0; y < size; ++y)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					std::size_t count = 0;
+					if (x > 0) neighbors[count++] = y * size + x - 1;
+					if (x < size - 1) neighbors[count++] = y * size + x + 1;
+					if (y > 0) neighbors[count++] = (y - 1) * size + x;
+					if (y < size - 1) neighbors[count++] = (y + 1) * size + x;
+					map.AddNode(maths::Vector2f(static_cast<float>(x), static_cast<float>(y)),
+						std::span<const NodeIndex>(neighbors, count));
+				}
+			}
+			benchmark::DoNotOptimize(map.node_count());
+		}
+		state.SetItemsProcessed(state.iterations() * size * size);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_GraphBuildRows)->Arg(1000)->Arg(2237)->Unit(benchmark::kMillisecond);
+
+	// Empty a frontier before a search, the indexed queue keeping its memory
+	template<typename T, typename priority_t>
+	void ClearFrontier(PriorityQueue<T, priority_t>& frontier)
+	{
+		frontier = PriorityQueue<T, priority_t>();
+	}
+
+	template<typename T, typename priority_t>
+	void ClearFrontier(IndexedPriorityQueue<T, priority_t>& frontier)
+	{
+		frontier.clear();
+	}
+
+	// Number of elements of a frontier, the copies of the plain queue included
+	template<typename T, typename priority_t>
+	std::size_t FrontierSize(const PriorityQueue<T, priority_t>& frontier)
+	{
+		return frontier.elements.size();
+	}
+
+	template<typename T, typename priority_t>
+	std::size_t FrontierSize(const IndexedPriorityQueue<T, priority_t>& frontier)
+	{
+		return frontier.size();
+	}
+
+	// A* over the grid with the given frontier, returning the largest size
+	// the frontier reached
+	template<typename Queue>
+	std::size_t SearchFrontier(const std::vector<Node>& graph, NodeIndex start_node, NodeIndex end_node,
+		Queue& frontier, std::vector<float>& cost_so_far)
+	{
+		std::fill(cost_so_far.begin(), cost_so_far.end(), std::numeric_limits<float>::max());
+		ClearFrontier(frontier);
+		frontier.put(start_node, 0.0f);
+		cost_so_far[start_node] = 0.0f;
+		std::size_t max_size = 1;
+		while (!frontier.empty())
+		{
+			const NodeIndex current = frontier.get();
+			if (current == end_node)
+			{
+				break;
+			}
+			for (NodeIndex next : graph[current].neighbors())
+			{
+				const float new_cost = cost_so_far[current] + Distance(graph[current], graph[next]);
+				if (new_cost < cost_so_far[next])
+				{
+					cost_so_far[next] = new_cost;
+					frontier.put(next, new_cost + Distance(graph[next], graph[end_node]));
+				}
+			}
+			max_size = std::max(max_size, FrontierSize(frontier));
+		}
+		return max_size;
+	}
+
+	template<typename Queue>
+	static void BM_FrontierSize(benchmark::State& state)
+	{
+		//Setup
+		const int size = static_cast<int>(state.range(0));
+		const std::vector<Node> graph = CreateGrid(size);
+		const auto queries = CreateQueries(size, 64);
+		std::vector<float> cost_so_far(graph.size());
+		Queue frontier;
+
+		std::size_t query_index = 0;
+		std::size_t max_size = 0;
+		for (auto _ : state)
+		{
+			const auto& [start, end] = queries[query_index++ % queries.size()];
+			max_size = std::max(max_size, SearchFrontier(graph, start, end, frontier, cost_so_far));
+		}
+		state.SetItemsProcessed(state.iterations());
+		state.counters["max_frontier_size"] = static_cast<double>(max_size);
+	}
+	// Register the function as a benchmark
+	BENCHMARK_TEMPLATE(BM_FrontierSize, PriorityQueue<NodeIndex, float>)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+	BENCHMARK_TEMPLATE(BM_FrontierSize, IndexedPriorityQueue<NodeIndex, float>)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+	// Put every item, then take them out one by one while lowering the
+	// priority of two of the items still waiting, as a search does
+	template<typename Queue>
+	static void BM_HeapOperations(benchmark::State& state)
+	{
+		//Setup
+		const NodeIndex count = static_cast<NodeIndex>(state.range(0));
+		std::mt19937 generator(9);
+		std::uniform_real_distribution<float> random_priority(0.0f, 1000.0f);
+		std::uniform_int_distribution<NodeIndex> random_item(0, count - 1);
+		std::vector<float> priorities(count);
+		std::vector<NodeIndex> lowered_items(2 * count);
+		std::vector<float> lowered_by(2 * count);
+		for (NodeIndex i = 0; i < count; ++i)
+		{
+			priorities[i] = random_priority(generator);
+		}
+		for (std::size_t i = 0; i < lowered_items.size(); ++i)
+		{
+			lowered_items[i] = random_item(generator);
+			lowered_by[i] = 0.1f * random_priority(generator);
+		}
+		std::vector<float> current(count);
+		std::vector<bool> done(count);
+		Queue queue;
+
+		std::size_t operation_count = 0;
+		for (auto _ : state)
+		{
+			ClearFrontier(queue);
+			std::copy(priorities.begin(), priorities.end(), current.begin());
+			std::fill(done.begin(), done.end(), false);
+			for (NodeIndex i = 0; i < count; ++i)
+			{
+				queue.put(i, current[i]);
+			}
+			operation_count += count;
+			std::size_t lowered = 0;
+			while (!queue.empty())
+			{
+				const NodeIndex item = queue.get();
+				++operation_count;
+				// The plain queue gives back the copies with an old priority
+				if (done[item])
+				{
+					continue;
+				}
+				done[item] = true;
+				for (int i = 0; i < 2 && lowered < lowered_items.size(); ++i, ++lowered)
+				{
+					const NodeIndex lowered_item = lowered_items[lowered];
+					if (!done[lowered_item])
+					{
+						current[lowered_item] -= lowered_by[lowered];
+						queue.put(lowered_item, current[lowered_item]);
+						++operation_count;
+					}
+				}
+			}
+		}
+		state.counters["operations_per_second"] = benchmark::Counter(
+			static_cast<double>(operation_count), benchmark::Counter::kIsRate);
+	}
+	// Register the function as a benchmark
+	BENCHMARK_TEMPLATE(BM_HeapOperations, PriorityQueue<NodeIndex, float>)->Arg(1000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+	BENCHMARK_TEMPLATE(BM_HeapOperations, IndexedPriorityQueue<NodeIndex, float>)->Arg(1000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+	// Batch of queries of many agents shared between the threads
+	static void BM_FindPathsThreads(benchmark::State& state)
+	{
+		//Setup
+		const int size = 200;
+		Map map;
+		for (const Node& node : CreateGrid(size))
+		{
+			map.AddNode(node);
+		}
+		std::vector<PathQuery> queries;
+		for (const auto& [start, end] : CreateQueries(size, 512))
+		{
+			queries.push_back({ start, end });
+		}
+		threading::ThreadPool pool(state.range(0));
+		map.FindPaths(queries, pool);
+
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(map.FindPaths(queries, pool));
+		}
+		state.SetItemsProcessed(state.iterations() * queries.size());
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_FindPathsThreads)->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+}
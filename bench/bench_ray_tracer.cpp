@@ -0,0 +1,753 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <filesystem>
+
+#include "raytracing/image_writer.h"
+#include "raytracing/ray_tracer.h"
+#include "raytracing/scene_file.h"
+#include "raytracing/wide_box.h"
+
+namespace raytracing
+{
+	// Fill a cube in front of the camera with random spheres,
+	// the cube grows with the count so the density stays the same.
+	std::vector<maths::Sphere> CreateRandomSpheres(std::size_t count)
+	{
+		std::mt19937 generator(42);
+		const float half_size = 2.0f * std::cbrt(static_cast<float>(count));
+		std::uniform_real_distribution<float> position(-half_size, half_size);
+
+		std::vector<maths::Sphere> spheres;
+		spheres.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			maths::Sphere sphere(0.5f, maths::Vector3f(
+				position(generator), position(generator), position(generator) - 2.0f * half_size));
+			sphere.set_material_index(static_cast<std::uint32_t>(i));
+			spheres.push_back(sphere);
+		}
+		return spheres;
+	}
+
+	// One material of random color for each of the random spheres
+	std::vector<Material> CreateRandomMaterials(std::size_t count)
+	{
+		std::mt19937 generator(13);
+		std::uniform_real_distribution<float> color(0.0f, 255.0f);
+		std::vector<Material> materials;
+		materials.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			materials.push_back(Material(0.2f,
+				maths::Vector3f(color(generator), color(generator), color(generator))));
+		}
+		return materials;
+	}
+
+	std::vector<maths::Vector3f> CreateRandomDirections(std::size_t count)
+	{
+		std::mt19937 generator(7);
+		std::uniform_real_distribution<float> spread(-0.5f, 0.5f);
+		std::vector<maths::Vector3f> directions;
+		directions.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			directions.push_back(maths::Vector3f(spread(generator), spread(generator), -1.0f).Normalized());
+		}
+		return directions;
+	}
+
+	static void BM_ObjectIntersect(benchmark::State& state, Acceleration acceleration)
+	{
+		//Setup
+		std::vector<maths::Sphere> spheres = CreateRandomSpheres(state.range(0));
+		std::vector<maths::Plane> planes;
+		const std::vector<maths::Vector3f> directions = CreateRandomDirections(1024);
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, planes, CreateRandomMaterials(spheres.size()), PointLight(), 1, 1, 51.52f, 1e-4);
+		raytracer.set_acceleration(acceleration);
+
+		std::size_t ray_index = 0;
+		for (auto _ : state)
+		{
+			maths::Ray3 ray(maths::Vector3f(0.0f, 0.0f, 0.0f), directions[ray_index++ % directions.size()]);
+			HitInfos hit_infos;
+			float distance;
+			benchmark::DoNotOptimize(raytracer.ObjectIntersect(ray, hit_infos, distance));
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	// Register the function as a benchmark
+	BENCHMARK_CAPTURE(BM_ObjectIntersect, BruteForce, Acceleration::kBruteForce)->Arg(10)->Arg(1000)->Arg(100000);
+	BENCHMARK_CAPTURE(BM_ObjectIntersect, Bvh, Acceleration::kBvh)->Arg(10)->Arg(1000)->Arg(100000);
+
+	// Shadow rays leaving from the middle of the spheres towards a light
+	// outside of them, most of them being blocked
+	static void BM_ShadowRay(benchmark::State& state, bool any_hit)
+	{
+		//Setup
+		std::vector<maths::Sphere> spheres = CreateRandomSpheres(state.range(0));
+		const float half_size = 2.0f * std::cbrt(static_cast<float>(state.range(0)));
+		const maths::Vector3f origin(0.0f, 0.0f, -2.0f * half_size);
+		const std::vector<maths::Vector3f> directions = CreateRandomDirections(1024);
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, std::vector<maths::Plane>(), CreateRandomMaterials(spheres.size()),
+			PointLight(), 1, 1, 51.52f, 1e-4);
+
+		std::size_t ray_index = 0;
+		for (auto _ : state)
+		{
+			const maths::Vector3f direction = directions[ray_index++ % directions.size()];
+			if (any_hit)
+			{
+				benchmark::DoNotOptimize(raytracer.Occluded(origin, direction, 4.0f * half_size));
+			}
+			else
+			{
+				// Previous shadow test, looking for the closest hit
+				maths::Ray3 ray(origin, direction);
+				HitInfos hit_infos;
+				float distance;
+				benchmark::DoNotOptimize(raytracer.ObjectIntersect(ray, hit_infos, distance));
+			}
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	// Register the function as a benchmark
+	BENCHMARK_CAPTURE(BM_ShadowRay, ClosestHit, false)->Arg(1000)->Arg(100000);
+	BENCHMARK_CAPTURE(BM_ShadowRay, AnyHit, true)->Arg(1000)->Arg(100000);
+
+	std::vector<maths::AABB3> CreateRandomBoxes(std::size_t count)
+	{
+		std::mt19937 generator(13);
+		std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> size(0.5f, 4.0f);
+		std::vector<maths::AABB3> boxes;
+		boxes.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const maths::Vector3f center(position(generator), position(generator), position(generator) - 30.0f);
+			const maths::Vector3f extent(size(generator), size(generator), size(generator));
+			boxes.emplace_back(center - extent, center + extent);
+		}
+		return boxes;
+	}
+
+	// Ray against each sphere of a scene, without any acceleration
+	static void BM_Ray3IntersectSphere(benchmark::State& state)
+	{
+		//Setup
+		const std::vector<maths::Sphere> spheres = CreateRandomSpheres(1024);
+		const std::vector<maths::Vector3f> directions = CreateRandomDirections(64);
+		std::size_t ray_index = 0;
+		for (auto _ : state)
+		{
+			maths::Ray3 ray(maths::Vector3f(0.0f, 0.0f, 0.0f), directions[ray_index++ % directions.size()]);
+			int hit_count = 0;
+			for (const maths::Sphere& sphere : spheres)
+			{
+				maths::Vector3f hit_position;
+				float distance;
+				hit_count += ray.IntersectSphere(sphere, hit_position, distance);
+			}
+			benchmark::DoNotOptimize(hit_count);
+		}
+		state.SetItemsProcessed(state.iterations() * spheres.size());
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_Ray3IntersectSphere);
+
+	// Planes facing the rays in every direction, half of them being hit
+	static void BM_Ray3IntersectPlane(benchmark::State& state)
+	{
+		//Setup
+		std::mt19937 generator(5);
+		std::uniform_real_distribution<float> spread(-1.0f, 1.0f);
+		std::vector<maths::Plane> planes;
+		planes.reserve(1024);
+		for (int i = 0; i < 1024; ++i)
+		{
+			const maths::Vector3f normal = maths::Vector3f(
+				spread(generator), spread(generator), spread(generator)).Normalized();
+			planes.emplace_back(normal * -20.0f, normal);
+		}
+		const std::vector<maths::Vector3f> directions = CreateRandomDirections(64);
+		std::size_t ray_index = 0;
+		for (auto _ : state)
+		{
+			maths::Ray3 ray(maths::Vector3f(0.0f, 0.0f, 0.0f), directions[ray_index++ % directions.size()]);
+			int hit_count = 0;
+			for (const maths::Plane& plane : planes)
+			{
+				maths::Vector3f hit_position;
+				hit_count += ray.IntersectPlane(plane, hit_position);
+			}
+			benchmark::DoNotOptimize(hit_count);
+		}
+		state.SetItemsProcessed(state.iterations() * planes.size());
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_Ray3IntersectPlane);
+
+	// Previous box test, inverting the direction at each call
+	static void BM_RayAABB3(benchmark::State& state)
+	{
+		//Setup
+		const std::vector<maths::AABB3> boxes = CreateRandomBoxes(1024);
+		const std::vector<maths::Vector3f> directions = CreateRandomDirections(64);
+		std::size_t ray_index = 0;
+		for (auto _ : state)
+		{
+			maths::Ray3 ray(maths::Vector3f(0.0f, 0.0f, 0.0f), directions[ray_index++ % directions.size()]);
+			int hit_count = 0;
+			for (const maths::AABB3& box : boxes)
+			{
+				hit_count += ray.IntersectAABB3(box);
+			}
+			benchmark::DoNotOptimize(hit_count);
+		}
+		state.SetItemsProcessed(state.iterations() * 1024);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_RayAABB3);
+
+	static void BM_SlabRay3(benchmark::State& state)
+	{
+		//Setup
+		const std::vector<maths::AABB3> boxes = CreateRandomBoxes(1024);
+		const std::vector<maths::Vector3f> directions = CreateRandomDirections(64);
+		std::size_t ray_index = 0;
+		for (auto _ : state)
+		{
+			const maths::SlabRay3 ray(maths::Vector3f(0.0f, 0.0f, 0.0f), directions[ray_index++ % directions.size()]);
+			int hit_count = 0;
+			for (const maths::AABB3& box : boxes)
+			{
+				float tmin;
+				float tmax;
+				hit_count += ray.IntersectAABB3(box, tmin, tmax);
+			}
+			benchmark::DoNotOptimize(hit_count);
+		}
+		state.SetItemsProcessed(state.iterations() * 1024);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_SlabRay3);
+
+	// Same boxes grouped by four, as the children of a wide node
+	static void BM_SlabRay3WideBox(benchmark::State& state)
+	{
+		//Setup
+		const std::vector<maths::AABB3> boxes = CreateRandomBoxes(1024);
+		std::vector<WideBox> wide_boxes(boxes.size() / kWideBoxSize);
+		for (std::size_t i = 0; i < boxes.size(); ++i)
+		{
+			wide_boxes[i / kWideBoxSize].Set(i % kWideBoxSize, boxes[i]);
+		}
+		const std::vector<maths::Vector3f> directions = CreateRandomDirections(64);
+		std::size_t ray_index = 0;
+		for (auto _ : state)
+		{
+			const maths::SlabRay3 ray(maths::Vector3f(0.0f, 0.0f, 0.0f), directions[ray_index++ % directions.size()]);
+			int hit_count = 0;
+			for (const WideBox& wide_box : wide_boxes)
+			{
+				float tmin[kWideBoxSize];
+				hit_count += std::popcount(static_cast<unsigned>(
+					IntersectWideBox(ray, wide_box, std::numeric_limits<float>::infinity(), tmin)));
+			}
+			benchmark::DoNotOptimize(hit_count);
+		}
+		state.SetItemsProcessed(state.iterations() * 1024);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_SlabRay3WideBox);
+
+	static void BM_BvhBuild(benchmark::State& state)
+	{
+		//Setup
+		const std::vector<maths::Sphere> spheres = CreateRandomSpheres(state.range(0));
+		std::vector<maths::AABB3> bounds;
+		for (const maths::Sphere& sphere : spheres)
+		{
+			bounds.push_back(sphere.bounds());
+		}
+		for (auto _ : state)
+		{
+			Bvh bvh;
+			bvh.Build(bounds);
+			benchmark::DoNotOptimize(bvh);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_BvhBuild)->Arg(10)->Arg(1000)->Arg(100000);
+
+	// Write a grid of side * side quads as an .obj file, 2 * side * side triangles
+	std::string WriteGridObj(int side)
+	{
+		const std::string path = (std::filesystem::temp_directory_path()
+			/ ("bench_grid_" + std::to_string(side) + ".obj")).string();
+		if (std::filesystem::exists(path))
+		{
+			return path;
+		}
+		std::ofstream ofs(path, std::ios::out | std::ios::binary);
+		for (int i = 0; i <= side; ++i)
+		{
+			for (int j = 0; j <= side; ++j)
+			{
+				ofs << "v " << j * 0.01f << " " << i * 0.01f << " " << std::sin(0.1f * (i + j)) << "\n";
+			}
+		}
+		for (int i = 0; i < side; ++i)
+		{
+			for (int j = 0; j < side; ++j)
+			{
+				const int corner = i * (side + 1) + j + 1;
+				ofs << "f " << corner << " " << corner + 1 << " " << corner + side + 2 << " " << corner + side + 1 << "\n";
+			}
+		}
+		return path;
+	}
+
+	static void BM_LoadObj(benchmark::State& state)
+	{
+		//Setup
+		const std::string path = WriteGridObj(static_cast<int>(state.range(0)));
+		TriangleMesh mesh;
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(LoadObj(path, mesh));
+		}
+		state.SetItemsProcessed(state.iterations() * mesh.triangle_count());
+		state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(path));
+		state.counters["triangles"] = static_cast<double>(mesh.triangle_count());
+		state.counters["mesh_bytes_per_triangle"] =
+			static_cast<double>(mesh.memory_size()) / mesh.triangle_count();
+	}
+	// Register the function as a benchmark, 2 * 708 * 708 is about 1M triangles
+	BENCHMARK(BM_LoadObj)->Arg(100)->Arg(708)->Unit(benchmark::kMillisecond);
+
+	// Write the random spheres as a text scene and convert it to a binary one
+	std::string WriteSphereScene(std::size_t count)
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path();
+		const std::string text_path = (directory / ("bench_scene_" + std::to_string(count) + ".txt")).string();
+		const std::string binary_path = (directory / ("bench_scene_" + std::to_string(count) + ".rtsc")).string();
+		if (!std::filesystem::exists(binary_path))
+		{
+			{
+				std::ofstream file(text_path);
+				file << "image 640 360\nmaterial 0.2 255 0 0\nlight 10 10 0\n";
+				for (const maths::Sphere& sphere : CreateRandomSpheres(count))
+				{
+					file << "sphere " << sphere.center().x << ' ' << sphere.center().y << ' '
+						<< sphere.center().z << ' ' << sphere.radius() << " 0\n";
+				}
+			}
+			ConvertSceneFile(text_path, binary_path);
+		}
+		return binary_path;
+	}
+
+	// Text scene parsed, or binary scene mapped, up to a raytracer ready to render
+	static void BM_LoadScene(benchmark::State& state, bool binary)
+	{
+		//Setup
+		const std::string binary_path = WriteSphereScene(state.range(0));
+		const std::string text_path = std::filesystem::path(binary_path).replace_extension(".txt").string();
+		Raytracer raytracer;
+		for (auto _ : state)
+		{
+			if (binary)
+			{
+				SceneFile scene_file;
+				scene_file.Open(binary_path);
+				raytracer.SetScene(scene_file);
+			}
+			else
+			{
+				MappedFile text;
+				text.Open(text_path);
+				SceneDescription scene;
+				ParseScene(text.view(), scene);
+				raytracer.SetScene(std::move(scene.spheres), std::move(scene.materials),
+					std::vector<maths::Plane>(), scene.lights[0], scene.height, scene.width, 1.0f, scene.bias);
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	// Register the function as a benchmark
+	BENCHMARK_CAPTURE(BM_LoadScene, Text, false)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+	BENCHMARK_CAPTURE(BM_LoadScene, Binary, true)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+	static void BM_MeshBvhBuild(benchmark::State& state)
+	{
+		//Setup
+		TriangleMesh mesh;
+		LoadObj(WriteGridObj(static_cast<int>(state.range(0))), mesh);
+		std::vector<maths::AABB3> bounds;
+		for (std::size_t i = 0; i < mesh.triangle_count(); ++i)
+		{
+			bounds.push_back(mesh.bounds(i));
+		}
+		Bvh bvh;
+		for (auto _ : state)
+		{
+			bvh.Build(bounds);
+		}
+		state.SetItemsProcessed(state.iterations() * mesh.triangle_count());
+		state.counters["bvh_bytes_per_triangle"] = static_cast<double>(
+			bvh.nodes().size() * sizeof(BvhNode) + bvh.primitive_indices().size() * sizeof(std::uint32_t))
+			/ mesh.triangle_count();
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_MeshBvhBuild)->Arg(100)->Arg(708)->Unit(benchmark::kMillisecond);
+
+	// Move every instance of a model of 1000 spheres and update the
+	// hierarchy over them, as done once per frame
+	static void BM_InstancesUpdate(benchmark::State& state)
+	{
+		//Setup
+		const std::size_t instance_count = state.range(0);
+		const std::vector<maths::Sphere> spheres = CreateRandomSpheres(1000);
+		Raytracer raytracer;
+		raytracer.SetScene(std::vector<maths::Sphere>(), std::vector<maths::Plane>(), CreateRandomMaterials(spheres.size()),
+			PointLight(), 1, 1, 51.52f, 1e-4);
+		const std::uint32_t model = raytracer.AddModel(spheres);
+		for (std::size_t i = 0; i < instance_count; ++i)
+		{
+			raytracer.AddInstance(model, maths::Matrix4f::translationMatrix(
+				maths::Vector3f(40.0f * (i % 100), 40.0f * (i / 100), 0.0f)));
+		}
+		raytracer.UpdateInstances();
+
+		float offset = 0.0f;
+		for (auto _ : state)
+		{
+			offset += 0.01f;
+			for (std::uint32_t i = 0; i < instance_count; ++i)
+			{
+				raytracer.SetInstanceTransform(i, maths::Matrix4f::translationMatrix(
+					maths::Vector3f(40.0f * (i % 100) + offset, 40.0f * (i / 100), 0.0f)));
+			}
+			raytracer.UpdateInstances();
+		}
+		state.SetItemsProcessed(state.iterations() * instance_count);
+
+		// Memory of the instanced scene against the same spheres copied in the scene
+		const Model& shared_model = raytracer.models()[model];
+		const double duplicated_bytes = static_cast<double>(instance_count)
+			* (shared_model.memory_size() - shared_model.bvh.nodes().size() * sizeof(BvhNode)
+				- shared_model.bvh.primitive_indices().size() * sizeof(std::uint32_t)
+				+ spheres.size() * (sizeof(std::uint32_t) + 2 * sizeof(BvhNode)));
+		state.counters["instanced_bytes"] = static_cast<double>(
+			shared_model.memory_size() + instance_count * (sizeof(Instance) + 2 * sizeof(BvhNode) + sizeof(std::uint32_t)));
+		state.counters["duplicated_bytes"] = duplicated_bytes;
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_InstancesUpdate)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+	// Scene where the left of the image holds many reflective spheres and
+	// the right is mostly background, so the work per row is uneven.
+	std::vector<maths::Sphere> CreateUnevenScene(std::vector<Material>& materials)
+	{
+		std::vector<maths::Sphere> spheres;
+		for (int j = 0; j < 20; ++j)
+		{
+			materials.push_back(Material(0.8f, maths::Vector3f(200.0f, 50.0f + 10.0f * j, 50.0f)));
+		}
+		for (int i = 0; i < 20; ++i)
+		{
+			for (int j = 0; j < 20; ++j)
+			{
+				maths::Sphere sphere(0.45f, maths::Vector3f(-10.0f + 0.5f * i, -5.0f + 0.5f * j, -15.0f - 0.3f * i));
+				sphere.set_material_index(j);
+				spheres.push_back(sphere);
+			}
+		}
+		return spheres;
+	}
+
+	static void BM_RenderThreads(benchmark::State& state)
+	{
+		//Setup
+		std::vector<Material> materials;
+		std::vector<maths::Sphere> spheres = CreateUnevenScene(materials);
+		std::vector<maths::Plane> planes;
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, planes, materials, PointLight(), 360, 640, 51.52f, 1e-4);
+		raytracer.set_thread_count(state.range(0));
+		for (auto _ : state)
+		{
+			raytracer.Render();
+		}
+		state.SetItemsProcessed(state.iterations() * 640 * 360);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_RenderThreads)->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+	// Lights spread among the spheres, each one lighting its surroundings
+	std::vector<PointLight> CreateRandomLights(std::size_t count, std::size_t sphere_count)
+	{
+		std::mt19937 generator(11);
+		const float half_size = 2.0f * std::cbrt(static_cast<float>(sphere_count));
+		std::uniform_real_distribution<float> position(-half_size, half_size);
+		std::vector<PointLight> lights(count);
+		for (PointLight& light : lights)
+		{
+			light.position = maths::Vector3f(
+				position(generator), position(generator), position(generator) - 2.0f * half_size);
+			light.intensity = 1.0f / static_cast<float>(count);
+			light.falloff_radius = 0.5f * half_size;
+		}
+		return lights;
+	}
+
+	static void BM_RenderLights(benchmark::State& state, bool sample_lights)
+	{
+		//Setup
+		std::vector<maths::Sphere> spheres = CreateRandomSpheres(1000);
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, std::vector<maths::Plane>(), CreateRandomMaterials(spheres.size()),
+			PointLight(), 90, 160, 51.52f, 1e-4);
+		raytracer.SetLights(CreateRandomLights(state.range(0), spheres.size()));
+		raytracer.set_thread_count(1);
+		if (!sample_lights)
+		{
+			raytracer.set_light_sample_count(static_cast<int>(state.range(0)));
+		}
+		for (auto _ : state)
+		{
+			raytracer.Render();
+		}
+		state.SetItemsProcessed(state.iterations() * 160 * 90);
+	}
+	// Register the function as a benchmark
+	BENCHMARK_CAPTURE(BM_RenderLights, EveryLight, false)->RangeMultiplier(4)->Range(1, 1024)->Unit(benchmark::kMillisecond);
+	BENCHMARK_CAPTURE(BM_RenderLights, Sampled, true)->RangeMultiplier(4)->Range(1, 1024)->Unit(benchmark::kMillisecond);
+
+	static void BM_RenderMode(benchmark::State& state, RenderMode render_mode)
+	{
+		//Setup
+		std::vector<maths::Sphere> spheres = CreateRandomSpheres(state.range(0));
+		std::vector<maths::Plane> planes;
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, planes, CreateRandomMaterials(spheres.size()), PointLight(), 360, 640, 51.52f, 1e-4);
+		raytracer.set_thread_count(1);
+		raytracer.set_render_mode(render_mode);
+		for (auto _ : state)
+		{
+			raytracer.Render();
+		}
+		state.counters["primary_rays_per_second"] = benchmark::Counter(
+			static_cast<double>(state.iterations()) * 640 * 360, benchmark::Counter::kIsRate);
+		if constexpr (kRenderStatsEnabled)
+		{
+			const RenderStats& stats = raytracer.render_stats();
+			state.counters["rays_per_frame"] = static_cast<double>(stats.ray_count());
+			state.counters["tests_per_ray"] = stats.intersection_tests_per_ray();
+			state.counters["nodes_per_ray"] =
+				static_cast<double>(stats.node_visits) / static_cast<double>(stats.ray_count());
+		}
+	}
+	// Register the function as a benchmark
+	BENCHMARK_CAPTURE(BM_RenderMode, Scalar, RenderMode::kScalar)->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+	BENCHMARK_CAPTURE(BM_RenderMode, Packet, RenderMode::kPacket)->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+	// Whole frame at growing resolutions, with the default settings
+	static void BM_RenderResolution(benchmark::State& state)
+	{
+		//Setup
+		const int width = static_cast<int>(state.range(0));
+		const int height = width * 9 / 16;
+		std::vector<maths::Sphere> spheres = CreateRandomSpheres(1000);
+		std::vector<maths::Plane> planes{ maths::Plane(
+			maths::Vector3f(0.0f, -40.0f, 0.0f), maths::Vector3f(0.0f, 1.0f, 0.0f)) };
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, planes, CreateRandomMaterials(spheres.size()),
+			PointLight(), height, width, 51.52f, 1e-4);
+		for (auto _ : state)
+		{
+			raytracer.Render();
+		}
+		state.counters["primary_rays_per_second"] = benchmark::Counter(
+			static_cast<double>(state.iterations()) * width * height, benchmark::Counter::kIsRate);
+		if constexpr (kRenderStatsEnabled)
+		{
+			// Shadow and reflection rays included
+			state.counters["rays_per_second"] = raytracer.render_stats().rays_per_second();
+		}
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_RenderResolution)->Arg(320)->Arg(640)->Arg(1280)->Arg(1920)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+	// Render with several stratified samples per pixel
+	static void BM_RenderSupersampled(benchmark::State& state, RenderMode render_mode)
+	{
+		//Setup
+		std::vector<maths::Sphere> spheres = CreateRandomSpheres(1000);
+		std::vector<maths::Plane> planes;
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, planes, CreateRandomMaterials(spheres.size()), PointLight(), 180, 320, 51.52f, 1e-4);
+		raytracer.set_thread_count(1);
+		raytracer.set_render_mode(render_mode);
+		raytracer.set_samples_per_pixel(static_cast<int>(state.range(0)));
+		for (auto _ : state)
+		{
+			raytracer.Render();
+		}
+		state.counters["primary_rays_per_second"] = benchmark::Counter(
+			static_cast<double>(state.iterations()) * 320 * 180 * state.range(0), benchmark::Counter::kIsRate);
+	}
+	// Register the function as a benchmark
+	BENCHMARK_CAPTURE(BM_RenderSupersampled, Scalar, RenderMode::kScalar)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond);
+	BENCHMARK_CAPTURE(BM_RenderSupersampled, Packet, RenderMode::kPacket)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond);
+
+	// Intersection of the two sphere layout benchmarks, the same arithmetic
+	// as IntersectSphere so only the loads of the sphere differ
+	inline bool HitSphere(float center_x, float center_y, float center_z, float radius,
+		const maths::Vector3f& origin, const maths::Vector3f& direction, float& distance)
+	{
+		const float v_x = center_x - origin.x;
+		const float v_y = center_y - origin.y;
+		const float v_z = center_z - origin.z;
+		const float d = v_x * direction.x + v_y * direction.y + v_z * direction.z;
+		if (d < 0.0f)
+		{
+			return false;
+		}
+		const float squared_distance = (v_x * v_x + v_y * v_y + v_z * v_z) - d * d;
+		const float radius2 = radius * radius;
+		if (squared_distance > radius2)
+		{
+			return false;
+		}
+		const float q = std::sqrt(radius2 - squared_distance);
+		const float t = d - q >= 0.0f ? d - q : d + q;
+		if (t >= distance)
+		{
+			return false;
+		}
+		distance = t;
+		return true;
+	}
+
+	// Closest hit over every sphere, the spheres being stored as objects
+	// holding their material
+	static void BM_SpheresArrayOfStructures(benchmark::State& state)
+	{
+		//Setup
+		std::vector<maths::Sphere> spheres = CreateRandomSpheres(state.range(0));
+		const std::vector<maths::Vector3f> directions = CreateRandomDirections(64);
+
+		std::size_t ray_index = 0;
+		for (auto _ : state)
+		{
+			const maths::Vector3f direction = directions[ray_index++ % directions.size()];
+			const maths::Vector3f origin(0.0f, 0.0f, 0.0f);
+			float distance = 1000000.0f;
+			std::size_t hit_index = 0;
+			for (std::size_t i = 0; i < spheres.size(); ++i)
+			{
+				const maths::Vector3f center = spheres[i].center();
+				if (HitSphere(center.x, center.y, center.z, spheres[i].radius(), origin, direction, distance))
+				{
+					hit_index = i;
+				}
+			}
+			benchmark::DoNotOptimize(hit_index);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+		state.counters["bytes_per_sphere"] = sizeof(maths::Sphere);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_SpheresArrayOfStructures)->Arg(1000)->Arg(100000)->Arg(1000000);
+
+	// Same loop on the spheres stored as arrays of components
+	static void BM_SpheresStructureOfArrays(benchmark::State& state)
+	{
+		//Setup
+		const std::vector<maths::Sphere> sphere_objects = CreateRandomSpheres(state.range(0));
+		SphereArrays spheres;
+		for (const maths::Sphere& sphere : sphere_objects)
+		{
+			spheres.push_back(sphere.center(), sphere.radius(), 0);
+		}
+		const std::vector<maths::Vector3f> directions = CreateRandomDirections(64);
+
+		std::size_t ray_index = 0;
+		for (auto _ : state)
+		{
+			const maths::Vector3f direction = directions[ray_index++ % directions.size()];
+			const maths::Vector3f origin(0.0f, 0.0f, 0.0f);
+			float distance = 1000000.0f;
+			std::size_t hit_index = 0;
+			for (std::size_t i = 0; i < spheres.size(); ++i)
+			{
+				if (HitSphere(spheres.center_x[i], spheres.center_y[i], spheres.center_z[i], spheres.radius[i],
+					origin, direction, distance))
+				{
+					hit_index = i;
+				}
+			}
+			benchmark::DoNotOptimize(hit_index);
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+		state.counters["bytes_per_sphere"] = 4 * sizeof(float);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_SpheresStructureOfArrays)->Arg(1000)->Arg(100000)->Arg(1000000);
+
+	// Previous image output, three stream insertions per pixel
+	static void BM_WriteImagePerByte(benchmark::State& state)
+	{
+		//Setup
+		const int width = 3840;
+		const int height = 2160;
+		std::vector<maths::Vector3f> frame_buffer(width * height, maths::Vector3f(100.0f, 300.0f, -5.0f));
+		const std::string path = (std::filesystem::temp_directory_path() / "bench_per_byte.ppm").string();
+		for (auto _ : state)
+		{
+			std::ofstream ofs(path, std::ios::out | std::ios::binary);
+			ofs << "P6\n" << width << " " << height << "\n255\n";
+			for (const maths::Vector3f& color : frame_buffer)
+			{
+				ofs << (char)std::clamp(color.x, 0.0f, 255.0f)
+					<< (char)std::clamp(color.y, 0.0f, 255.0f)
+					<< (char)std::clamp(color.z, 0.0f, 255.0f);
+			}
+		}
+		std::filesystem::remove(path);
+		state.SetBytesProcessed(state.iterations() * width * height * 3);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_WriteImagePerByte)->Unit(benchmark::kMillisecond);
+
+	static void BM_WriteImageBulk(benchmark::State& state)
+	{
+		//Setup
+		const int width = 3840;
+		const int height = 2160;
+		std::vector<maths::Vector3f> frame_buffer(width * height, maths::Vector3f(100.0f, 300.0f, -5.0f));
+		std::vector<std::uint8_t> rgb;
+		const std::string path = (std::filesystem::temp_directory_path() / "bench_bulk.ppm").string();
+		for (auto _ : state)
+		{
+			ConvertToRgb8(frame_buffer, rgb);
+			benchmark::DoNotOptimize(WritePpm(path, width, height, rgb));
+		}
+		std::filesystem::remove(path);
+		state.SetBytesProcessed(state.iterations() * width * height * 3);
+	}
+	// Register the function as a benchmark
+	BENCHMARK(BM_WriteImageBulk)->Unit(benchmark::kMillisecond);
+}
@@ -45,6 +45,12 @@ public:
 
 	Vector3f bottom_left() const { return bottom_left_; }
 	Vector3f top_right() const { return top_right_; }
+
+	// Return the area of the six faces, used as a cost by the SAH
+	float SurfaceArea() const {
+		const Vector3f size = top_right_ - bottom_left_;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
 	
 private:
 	Vector3f bottom_left_ = {};
@@ -55,5 +61,7 @@ private:
 bool Overlap(const AABB3& a, const AABB3& b);
 // To find out if one AABB is contained in the other
 bool Contain(const AABB3& a, const AABB3& b);
+// To get the smallest AABB enclosing the two given AABB
+AABB3 Merge(const AABB3& a, const AABB3& b);
 	
 }  // namespace maths
\ No newline at end of file
@@ -34,6 +34,9 @@ namespace maths {
 class Frustum {
 public:
 	Frustum() = default;
+	// Frustum from its planes in the order near, far, left, right, top, bottom,
+	// their normals facing the inside
+	explicit Frustum(const std::array<Plane, 6>& planes) : planes_(planes) {}
 	// Calculate frustum from the given informations from the camera each time it is called
 	void calculate_frustum(Vector3f direction, Vector3f position, Vector3f right, 
 		Vector3f up, float near_plane_distance, float far_plane_distance, 
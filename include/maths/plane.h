@@ -23,8 +23,9 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <cstdint>
+
 #include "maths/vector3.h"
-#include "raytracing/material.h"
 
 namespace maths
 {
@@ -51,13 +52,14 @@ public:
 	
 	Vector3f point() const { return { point_ }; }
 	Vector3f normal() const { return { normal_ }; }
-	void SetMaterial(Material material) { material_ = material; }
-	Material material() const { return material_; }
+	// Index of the material in the material table of the scene
+	std::uint32_t material_index() const { return material_index_; }
+	void set_material_index(std::uint32_t material_index) { material_index_ = material_index; }
 	
 private:
 	Vector3f point_;
 	Vector3f normal_;
-	Material material_;
+	std::uint32_t material_index_ = 0;
 };
 
 } // namespace maths
\ No newline at end of file
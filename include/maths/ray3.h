@@ -23,6 +23,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
 #include "maths/sphere.h"
 #include "maths/aabb3.h"
 #include "maths/plane.h"
@@ -56,4 +60,69 @@ private:
 	Vector3f hit_position_;
 };
 
+// Ray prepared to be tested against many boxes, the inverse of its
+// direction and the sign of each of its components are computed once
+class SlabRay3 {
+public:
+	SlabRay3() = default;
+	SlabRay3(const Vector3f& origin, const Vector3f& direction) :
+		origin_(origin),
+		direction_(direction),
+		inv_direction_(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z)
+	{
+		for (int axis = 0; axis < 3; ++axis) {
+			sign_[axis] = inv_direction_[axis] < 0.0f ? 1 : 0;
+		}
+	}
+	explicit SlabRay3(const Ray3& ray) : SlabRay3(ray.origin(), ray.direction()) {}
+
+	const Vector3f& origin() const { return origin_; }
+	const Vector3f& direction() const { return direction_; }
+	const Vector3f& inv_direction() const { return inv_direction_; }
+	// 1 if the direction is negative along the axis, 0 otherwise
+	int sign(int axis) const { return sign_[axis]; }
+
+	// Set tmin and tmax to the distances where the ray enters and leaves the
+	// box, without any branch. Return true if the ray enters the box before
+	// max_distance and leaves it in front of its origin.
+	bool IntersectAABB3(
+		const Vector3f& bounds_min,
+		const Vector3f& bounds_max,
+		float max_distance,
+		float& tmin,
+		float& tmax) const;
+	bool IntersectAABB3(const AABB3& aabb, float& tmin, float& tmax) const {
+		return IntersectAABB3(aabb.bottom_left(), aabb.top_right(),
+			std::numeric_limits<float>::infinity(), tmin, tmax);
+	}
+
+private:
+	Vector3f origin_ = {};
+	Vector3f direction_ = {};
+	Vector3f inv_direction_ = {};
+	std::uint8_t sign_[3] = {};
+};
+
+inline bool SlabRay3::IntersectAABB3(
+	const Vector3f& bounds_min,
+	const Vector3f& bounds_max,
+	float max_distance,
+	float& tmin,
+	float& tmax) const {
+	// The sign tells which side of the box the ray enters on each axis,
+	// so the entry and exit distances need no min and max
+	const Vector3f* bounds[2] = { &bounds_min, &bounds_max };
+	tmin = (bounds[sign_[0]]->x - origin_.x) * inv_direction_.x;
+	tmax = (bounds[1 - sign_[0]]->x - origin_.x) * inv_direction_.x;
+	const float tymin = (bounds[sign_[1]]->y - origin_.y) * inv_direction_.y;
+	const float tymax = (bounds[1 - sign_[1]]->y - origin_.y) * inv_direction_.y;
+	tmin = std::max(tmin, tymin);
+	tmax = std::min(tmax, tymax);
+	const float tzmin = (bounds[sign_[2]]->z - origin_.z) * inv_direction_.z;
+	const float tzmax = (bounds[1 - sign_[2]]->z - origin_.z) * inv_direction_.z;
+	tmin = std::max(tmin, tzmin);
+	tmax = std::min(tmax, tzmax);
+	return (tmax >= tmin) & (tmin < max_distance) & (tmax > 0.0f);
+}
+
 } // namespace maths
\ No newline at end of file
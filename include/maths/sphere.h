@@ -24,9 +24,9 @@ SOFTWARE.
 */
 
 #include <math.h>
+#include <cstdint>
 #include "maths/vector3.h"
 #include "aabb3.h"
-#include "raytracing/material.h"
 
 namespace maths {
 class Sphere {
@@ -52,13 +52,19 @@ public:
     void set_radius(float radius) { radius_ = radius; }
     Vector3f center() const { return center_; }
     float radius() const { return radius_; }
-    Material material() const { return material_; }
-    void set_material(Material material) { material_ = material; }
+    // Return the smallest AABB enclosing the sphere
+    AABB3 bounds() const {
+        const Vector3f extent(radius_, radius_, radius_);
+        return { center_ - extent, center_ + extent };
+    }
+    // Index of the material in the material table of the scene
+    std::uint32_t material_index() const { return material_index_; }
+    void set_material_index(std::uint32_t material_index) { material_index_ = material_index; }
 
 private:
     Vector3f center_ = {};
     float radius_ = {};
-    Material material_ = {};
+    std::uint32_t material_index_ = 0;
 };
 
 bool OverlapSphere(const Sphere& a, const Sphere& b);
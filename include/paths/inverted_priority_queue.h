@@ -24,8 +24,12 @@ SOFTWARE.
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <queue>
+#include <vector>
 
 // Queue who sort the element from lowest to higher.
 template<typename T, typename priority_t>
@@ -53,3 +57,145 @@ public:
 	}
 
 };
+
+// Queue who sort the indices from lowest to higher priority, each index
+// being in the queue once. Putting an index already in the queue with a
+// lower priority moves it up instead of adding a copy. The elements are
+// in a 4-ary heap, and the place of each index in the heap is kept in a
+// table indexed by the index.
+template<typename T, typename priority_t>
+class IndexedPriorityQueue {
+public:
+	static constexpr std::size_t kArity = 4;
+
+	struct Element {
+		priority_t priority;
+		T item;
+	};
+
+	// Return if the queue is empty.
+	bool empty() const {
+		return elements_.empty();
+	}
+
+	// Return the number of elements in the queue.
+	std::size_t size() const {
+		return elements_.size();
+	}
+
+	// Return if the item is in the queue.
+	bool contains(T item) const {
+		return item < positions_.size() && positions_[item] != kNoPosition;
+	}
+
+	// Return the priority of an item in the queue.
+	priority_t priority(T item) const {
+		return elements_[positions_[item]].priority;
+	}
+
+	// Make room for the items lower than item_count, and for as many
+	// elements in the heap.
+	void reserve(std::size_t item_count) {
+		if (positions_.size() < item_count) {
+			positions_.resize(item_count, kNoPosition);
+		}
+		elements_.reserve(item_count);
+	}
+
+	// Put an item in the queue, or lower its priority if it is already in
+	// the queue with a higher one.
+	void put(T item, priority_t priority) {
+		if (item >= positions_.size()) {
+			positions_.resize(static_cast<std::size_t>(item) + 1, kNoPosition);
+		}
+		std::uint32_t position = positions_[item];
+		if (position == kNoPosition) {
+			position = static_cast<std::uint32_t>(elements_.size());
+			elements_.push_back({ priority, item });
+		}
+		else if (Less({ priority, item }, elements_[position])) {
+			elements_[position].priority = priority;
+		}
+		else {
+			return;
+		}
+		SiftUp(position);
+	}
+
+	// Return the element with the lowest priority.
+	T get() {
+		const T best_item = elements_.front().item;
+		positions_[best_item] = kNoPosition;
+		const Element last = elements_.back();
+		elements_.pop_back();
+		if (!elements_.empty()) {
+			elements_.front() = last;
+			positions_[last.item] = 0;
+			SiftDown(0);
+		}
+		return best_item;
+	}
+
+	// Remove every element, keeping the memory for the next use.
+	void clear() {
+		for (const Element& element : elements_) {
+			positions_[element.item] = kNoPosition;
+		}
+		elements_.clear();
+	}
+
+private:
+	static constexpr std::uint32_t kNoPosition = std::numeric_limits<std::uint32_t>::max();
+
+	// Order of the elements, the items break the ties like in PriorityQueue.
+	static bool Less(const Element& a, const Element& b) {
+		return a.priority < b.priority || (!(b.priority < a.priority) && a.item < b.item);
+	}
+
+	// Move the element up while it is lower than its parent.
+	void SiftUp(std::uint32_t position) {
+		const Element element = elements_[position];
+		while (position > 0) {
+			const std::uint32_t parent = (position - 1) / kArity;
+			if (!Less(element, elements_[parent])) {
+				break;
+			}
+			elements_[position] = elements_[parent];
+			positions_[elements_[position].item] = position;
+			position = parent;
+		}
+		elements_[position] = element;
+		positions_[element.item] = position;
+	}
+
+	// Move the element down while one of its children is lower.
+	void SiftDown(std::uint32_t position) {
+		const Element element = elements_[position];
+		const std::size_t count = elements_.size();
+		while (true) {
+			const std::size_t first_child = position * kArity + 1;
+			if (first_child >= count) {
+				break;
+			}
+			const std::size_t last_child = std::min(first_child + kArity, count);
+			std::size_t best_child = first_child;
+			for (std::size_t child = first_child + 1; child < last_child; ++child) {
+				if (Less(elements_[child], elements_[best_child])) {
+					best_child = child;
+				}
+			}
+			if (!Less(elements_[best_child], element)) {
+				break;
+			}
+			elements_[position] = elements_[best_child];
+			positions_[elements_[position].item] = position;
+			position = static_cast<std::uint32_t>(best_child);
+		}
+		elements_[position] = element;
+		positions_[element.item] = position;
+	}
+
+	std::vector<Element> elements_;
+	// The place of each item in elements_, or kNoPosition.
+	std::vector<std::uint32_t> positions_;
+};
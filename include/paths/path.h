@@ -24,9 +24,21 @@ SOFTWARE.
 
 #pragma once
 
-#include <map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <queue>
+#include <span>
+#include <utility>
 #include <vector>
 #include "maths/vector2.h"
+#include "paths/inverted_priority_queue.h"
+#include "thread_pool.h"
 
 namespace path {
 	
@@ -36,10 +48,8 @@ using NodeIndex = std::uint32_t;
 class Node {
 public:
 	Node() = default;
-	Node(maths::Vector2f position, std::vector<NodeIndex> neighbors) {
-		position_ = position;
-		neighbors_ = neighbors;
-	}
+	Node(maths::Vector2f position, std::vector<NodeIndex> neighbors)
+		: neighbors_(std::move(neighbors)), position_(position) {}
 
 	// This function returns the neighbors of a node.
 	const std::vector<NodeIndex>& neighbors() const {
@@ -51,39 +61,266 @@ public:
 		return position_;
 	}
 
-	Node& operator=(Node node) {
-		position_ = node.position_;
-		neighbors_ = node.neighbors_;
-		return *this;
-	}
 private:
 	std::vector<NodeIndex> neighbors_;
 	maths::Vector2f position_;
 };
 
-// This class is used to represent a map.
+// Straight line distance, the heuristic of the Euclidean edge costs.
+struct EuclideanHeuristic {
+	float operator()(float dx, float dy) const {
+		return std::sqrt(dx * dx + dy * dy);
+	}
+};
+
+// Distance along the axes, for graphs moving in four directions.
+struct ManhattanHeuristic {
+	float operator()(float dx, float dy) const {
+		return std::abs(dx) + std::abs(dy);
+	}
+};
+
+// Distance along the axes and the diagonals, for graphs moving in eight
+// directions.
+struct OctileHeuristic {
+	float operator()(float dx, float dy) const {
+		const float x = std::abs(dx);
+		const float y = std::abs(dy);
+		return std::max(x, y) + (std::numbers::sqrt2_v<float> - 1.0f) * std::min(x, y);
+	}
+};
+
+// No estimate, the search becomes Dijkstra's.
+struct ZeroHeuristic {
+	float operator()(float, float) const {
+		return 0.0f;
+	}
+};
+
+// A path query, from the start node to the end node.
+struct PathQuery {
+	NodeIndex start_node = 0;
+	NodeIndex end_node = 0;
+};
+
+// The state of a query, a map can be searched by as many threads at
+// once as there are contexts. Its arrays grow to the size of the graph
+// and are kept between the queries.
+struct SearchContext {
+	// This function starts a new query, the nodes visited by the previous
+	// queries are forgotten without touching the arrays.
+	void NextGeneration(std::size_t node_count);
+	// This function returns if the node was reached during the current query.
+	bool Visited(NodeIndex node) const {
+		return visited_generation[node] == generation;
+	}
+
+	std::vector<NodeIndex> path;
+	// The nodes to visit.
+	IndexedPriorityQueue<NodeIndex, float> frontier;
+	// The node with the lowest cost to go to each node, valid for the
+	// visited nodes only.
+	std::vector<NodeIndex> came_from;
+	// The lowest cost to go to each node, valid for the visited nodes only.
+	std::vector<float> cost_so_far;
+	// The query during which each node was last reached.
+	std::vector<std::uint32_t> visited_generation;
+	std::uint32_t generation = 0;
+};
+
+// The search contexts of the threads of a batch, a context being used
+// by one thread at a time.
+class SearchContextPool {
+public:
+	// This function takes a free context, or creates one.
+	std::unique_ptr<SearchContext> Acquire();
+	// This function gives back a context for the next thread.
+	void Release(std::unique_ptr<SearchContext> context);
+	void Clear();
+private:
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<SearchContext>> contexts_;
+};
+
+// This class is used to represent a map. The graph is stored in
+// compressed rows: the neighbors of every node follow each other in one
+// array, the neighbors of a node going from its offset to the offset of
+// the next node. The cost of an edge is known as soon as both of its nodes
+// are added, so the queries only read the graph: any number of threads can
+// search it at once, as long as no node is added meanwhile.
 class Map {
 public:
 	Map() = default;
-	// This function push a node in graph_.
+	// This function push a node at the end of the graph.
 	void AddNode(const Node& node) {
-		graph_.push_back(node);
+		AddNode(node.position(), node.neighbors());
 	}
+	// This function push a node at the end of the graph without building a
+	// Node, the cost of its edges being the distance to the neighbors. The
+	// distance to a neighbor added later is computed when it is added.
+	void AddNode(maths::Vector2f position, std::span<const NodeIndex> neighbors);
+	// This function push a node with a cost for each of its neighbors, such
+	// as terrain costs, given in the order of the neighbors. The heuristic
+	// of the queries must not overestimate these costs for the path to be
+	// the lowest cost one.
+	void AddNode(maths::Vector2f position, std::span<const NodeIndex> neighbors,
+		std::span<const float> edge_costs);
+	// This function makes room for the nodes and the edges to come.
+	void Reserve(std::size_t node_count, std::size_t edge_count);
 	// This function find the lowest cost path with A* from the start node to the last node.
-	std::vector<NodeIndex> FindPath(NodeIndex start_node, NodeIndex end_node);
+	std::vector<NodeIndex> FindPath(NodeIndex start_node, NodeIndex end_node) const;
+	// This function find the lowest cost path with A*, estimating the cost
+	// left from the offset (dx, dy) to the last node with the heuristic.
+	template<typename Heuristic>
+	std::vector<NodeIndex> FindPath(NodeIndex start_node, NodeIndex end_node, Heuristic heuristic) const;
+	// This function find the lowest cost path with the given context, which
+	// holds the state of the search so that it is not taken from the pool
+	// of the map. The edges towards nodes not added yet are not followed.
+	template<typename Heuristic>
+	std::vector<NodeIndex> FindPath(NodeIndex start_node, NodeIndex end_node,
+		SearchContext& context, Heuristic heuristic) const;
+	// This function find the path of every query, the queries being shared
+	// between the threads of the pool. The paths are in the order of the
+	// queries. Several threads can run batches on the same map at once,
+	// each with its own pool.
+	template<typename Heuristic = EuclideanHeuristic>
+	std::vector<std::vector<NodeIndex>> FindPaths(std::span<const PathQuery> queries,
+		threading::ThreadPool& pool, Heuristic heuristic = Heuristic()) const;
 	void Reset() {
-		graph_.clear();
-		path_.clear();
-		came_from_.clear();
-		cost_so_far_.clear();
+		offsets_.assign(1, 0);
+		neighbors_.clear();
+		edge_costs_.clear();
+		pending_edges_ = {};
+		positions_x_.clear();
+		positions_y_.clear();
+		context_pool_->Clear();
+	}
+
+	// This function returns the number of nodes of the graph.
+	std::size_t node_count() const {
+		return positions_x_.size();
+	}
+	// This function returns the neighbors of a node.
+	std::span<const NodeIndex> neighbors(NodeIndex node) const {
+		return { neighbors_.data() + offsets_[node], neighbors_.data() + offsets_[node + 1] };
+	}
+	// This function returns the position of a node.
+	maths::Vector2f position(NodeIndex node) const {
+		return { positions_x_[node], positions_y_[node] };
 	}
 private:
-	std::vector<Node> graph_;
-	std::vector<NodeIndex> path_;
-	// The node with the lowest cost to go to the key node.
-	std::map<NodeIndex, NodeIndex> came_from_;
-	// The lowest cost to go to a node.
-	std::map<NodeIndex, float> cost_so_far_;
+	// Cost of the edges towards a node not added yet, NaN so that it is
+	// never mistaken for a cost given to AddNode.
+	static constexpr float kDistanceCost = std::numeric_limits<float>::quiet_NaN();
+	// Number of queries of a task of FindPaths.
+	static constexpr std::size_t kQueriesPerTask = 16;
+
+	// An edge waiting for its neighbor to be added.
+	struct PendingEdge {
+		NodeIndex neighbor;
+		NodeIndex node;
+		std::uint32_t edge;
+		bool operator>(const PendingEdge& other) const {
+			return neighbor > other.neighbor;
+		}
+	};
+
+	// This function returns the distance between two nodes.
+	float Distance(NodeIndex node, NodeIndex other) const;
+	// This function computes the cost of the edges waiting for the last node.
+	void ResolvePendingEdges();
+	// This function gets the arrays of the context ready and puts the start
+	// node in its frontier.
+	void BeginQuery(NodeIndex start_node, SearchContext& context) const;
+	// This function follows the nodes back from the end node.
+	static std::vector<NodeIndex> BuildPath(NodeIndex start_node, NodeIndex end_node, SearchContext& context);
+
+	// The first edge of each node, followed by the edge count.
+	std::vector<std::uint32_t> offsets_ = { 0 };
+	// The neighbors of all the nodes, one after the other.
+	std::vector<NodeIndex> neighbors_;
+	// The cost of each edge.
+	std::vector<float> edge_costs_;
+	// The edges towards nodes not added yet, the lowest neighbor first.
+	std::priority_queue<PendingEdge, std::vector<PendingEdge>, std::greater<PendingEdge>> pending_edges_;
+	std::vector<float> positions_x_;
+	std::vector<float> positions_y_;
+	// The contexts of the queries, shared by the threads searching the map.
+	std::unique_ptr<SearchContextPool> context_pool_ = std::make_unique<SearchContextPool>();
 };
 
+template<typename Heuristic>
+std::vector<NodeIndex> Map::FindPath(NodeIndex start_node, NodeIndex end_node, Heuristic heuristic) const {
+	std::unique_ptr<SearchContext> context = context_pool_->Acquire();
+	std::vector<NodeIndex> path = FindPath(start_node, end_node, *context, heuristic);
+	context_pool_->Release(std::move(context));
+	return path;
+}
+
+template<typename Heuristic>
+std::vector<NodeIndex> Map::FindPath(NodeIndex start_node, NodeIndex end_node,
+	SearchContext& context, Heuristic heuristic) const {
+	const std::size_t node_count = positions_x_.size();
+	if (start_node >= node_count || end_node >= node_count) {
+		return {};
+	}
+	BeginQuery(start_node, context);
+	const float end_x = positions_x_[end_node];
+	const float end_y = positions_y_[end_node];
+
+	while (!context.frontier.empty()) {
+		// Get the lowest priority node.
+		const NodeIndex current = context.frontier.get();
+
+		if (current == end_node) {
+			return BuildPath(start_node, end_node, context);
+		}
+
+		for (std::uint32_t edge = offsets_[current]; edge < offsets_[current + 1]; ++edge) {
+			const NodeIndex next = neighbors_[edge];
+			// The node is not added yet, the edge has no cost.
+			if (next >= node_count) {
+				continue;
+			}
+			// The cost to get to the current node added to the cost of the edge.
+			const float new_cost = context.cost_so_far[current] + edge_costs_[edge];
+			/* Check if the node has been checked and if cost to go to the next
+			node from current is less than the lowest cost saved to go to the
+			next node.*/
+			if (!context.Visited(next) || new_cost < context.cost_so_far[next]) {
+				// Put the new lowest cost to go to next node.
+				context.cost_so_far[next] = new_cost;
+				context.visited_generation[next] = context.generation;
+				// Calculate the heuristic.
+				const float priority = new_cost
+					+ heuristic(positions_x_[next] - end_x, positions_y_[next] - end_y);
+				/* Add to nodes where we will check these neighbors, or lower
+				its priority if it is already waiting. */
+				context.frontier.put(next, priority);
+				/* Save the current node with the lowest cost to go to the next
+				node. */
+				context.came_from[next] = current;
+			}
+		}
+	}
+	// Return an empty vector of NodeIndex if there is no path to go to the end node.
+	return {};
+}
+
+template<typename Heuristic>
+std::vector<std::vector<NodeIndex>> Map::FindPaths(std::span<const PathQuery> queries,
+	threading::ThreadPool& pool, Heuristic heuristic) const {
+	std::vector<std::vector<NodeIndex>> paths(queries.size());
+	const std::size_t task_count = (queries.size() + kQueriesPerTask - 1) / kQueriesPerTask;
+	pool.ParallelFor(task_count, [&](std::size_t task_index) {
+		std::unique_ptr<SearchContext> context = context_pool_->Acquire();
+		const std::size_t end = std::min(queries.size(), (task_index + 1) * kQueriesPerTask);
+		for (std::size_t i = task_index * kQueriesPerTask; i < end; ++i) {
+			paths[i] = FindPath(queries[i].start_node, queries[i].end_node, *context, heuristic);
+		}
+		context_pool_->Release(std::move(context));
+	});
+	return paths;
+}
+
 }  // namespace path
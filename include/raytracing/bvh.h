@@ -0,0 +1,442 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "maths/aabb3.h"
+#include "maths/ray3.h"
+#include "maths/vector3.h"
+#include "raytracing/ray_packet.h"
+#include "raytracing/render_stats.h"
+
+namespace raytracing {
+
+// Node of the flattened hierarchy, kept at 32 bytes so two nodes share a cache line.
+// An inner node stores the index of its left child, the right child is always
+// stored just after it. A leaf stores the range of its primitives.
+struct BvhNode {
+	maths::Vector3f bounds_min;
+	std::uint32_t left_first = 0;
+	maths::Vector3f bounds_max;
+	std::uint32_t primitive_count = 0;
+
+	bool IsLeaf() const { return primitive_count != 0; }
+};
+
+// Bounding volume hierarchy built with a binned surface area heuristic
+// and stored as a contiguous array of nodes.
+class Bvh {
+public:
+	static constexpr float kMiss = std::numeric_limits<float>::infinity();
+
+	Bvh() = default;
+
+	// Build the hierarchy over the given bounds. The indices given to the
+	// intersect callback are the positions of the primitives in bounds.
+	void Build(const std::vector<maths::AABB3>& bounds);
+
+	// Update the bounds of every node after the primitives moved, keeping the
+	// tree as it is. Much cheaper than Build, but the tree gets worse as the
+	// primitives move away from where they were built.
+	void Refit(const std::vector<maths::AABB3>& bounds);
+
+	// Number the primitives below count in the order the leaves hold them and
+	// return the previous index of each, so the caller can store them in that
+	// order and read them one after the other in a leaf. The primitives from
+	// count on keep their index.
+	std::vector<std::uint32_t> RenumberPrimitives(std::size_t count);
+
+	// Take a hierarchy built before, as saved from nodes() and primitive_indices()
+	void Assign(std::span<const BvhNode> nodes, std::span<const std::uint32_t> primitive_indices);
+
+	// Check a hierarchy read from outside before assigning it: the children
+	// and the leaf ranges stay in the arrays, the children come after their
+	// parent, every node is the child of exactly one parent, the primitive
+	// indices are below primitive_count and the depth fits the traversal stack
+	static bool IsValid(
+		std::span<const BvhNode> nodes,
+		std::span<const std::uint32_t> primitive_indices,
+		std::size_t primitive_count);
+
+	void Clear() {
+		nodes_.clear();
+		primitive_indices_.clear();
+	}
+
+	bool empty() const { return nodes_.empty(); }
+	const std::vector<BvhNode>& nodes() const { return nodes_; }
+	const std::vector<std::uint32_t>& primitive_indices() const { return primitive_indices_; }
+
+	// Return the entry distance of the ray in the node, or kMiss if the node
+	// is not hit before max_distance
+	static float IntersectNode(
+		const BvhNode& node,
+		const maths::SlabRay3& ray,
+		float max_distance);
+
+	// Traverse the hierarchy front to back and call intersect(index, distance)
+	// for each primitive of the visited leaves. The callback returns true when
+	// it found a hit closer than distance and shortens distance accordingly.
+	template<typename IntersectFunc>
+	bool Intersect(
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float& distance,
+		IntersectFunc&& intersect) const;
+
+	// Traverse the hierarchy in any order until occluded(index) returns true
+	// for a primitive of a visited leaf. Only the nodes entered before
+	// max_distance are visited, the callback tests its primitive against it.
+	template<typename OcclusionFunc>
+	bool Occluded(
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float max_distance,
+		OcclusionFunc&& occluded) const;
+
+	// Traverse the hierarchy with a packet of rays, a node is visited while
+	// at least one active ray enters it. intersect(index, mask) is called
+	// for each primitive of the visited leaves with the mask of the rays
+	// that entered the leaf, updates hit and returns the mask of the rays
+	// that got a closer hit. Once a single ray is left in a subtree,
+	// the subtree is traversed with the scalar traversal.
+	template<typename IntersectFunc>
+	void IntersectPacket(
+		const RayPacket& packet,
+		PacketHit& hit,
+		int active_mask,
+		IntersectFunc&& intersect) const;
+
+private:
+	template<typename IntersectFunc>
+	bool IntersectFrom(
+		std::uint32_t root_index,
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float& distance,
+		IntersectFunc&& intersect) const;
+
+	// Past this depth the node becomes a leaf, it also bounds the traversal stack
+	static constexpr int kMaxDepth = 64;
+	static constexpr int kBinCount = 16;
+	static constexpr std::uint32_t kMaxLeafSize = 8;
+
+	void UpdateNodeBounds(std::uint32_t node_index, const std::vector<maths::AABB3>& bounds);
+	void Subdivide(
+		std::uint32_t node_index,
+		const std::vector<maths::AABB3>& bounds,
+		const std::vector<maths::Vector3f>& centroids,
+		int depth);
+
+	std::vector<BvhNode> nodes_;
+	std::vector<std::uint32_t> primitive_indices_;
+};
+
+inline float Bvh::IntersectNode(
+	const BvhNode& node,
+	const maths::SlabRay3& ray,
+	float max_distance)
+{
+	float tmin;
+	float tmax;
+	if (ray.IntersectAABB3(node.bounds_min, node.bounds_max, max_distance, tmin, tmax))
+	{
+		return tmin;
+	}
+	return kMiss;
+}
+
+template<typename IntersectFunc>
+bool Bvh::Intersect(
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance,
+	IntersectFunc&& intersect) const
+{
+	if (nodes_.empty())
+	{
+		return false;
+	}
+	return IntersectFrom(0, origin, direction, distance, intersect);
+}
+
+template<typename IntersectFunc>
+bool Bvh::IntersectFrom(
+	std::uint32_t root_index,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance,
+	IntersectFunc&& intersect) const
+{
+	const maths::SlabRay3 ray(origin, direction);
+	if (IntersectNode(nodes_[root_index], ray, distance) == kMiss)
+	{
+		return false;
+	}
+
+	// Far children waiting to be visited, with their entry distance
+	std::pair<std::uint32_t, float> stack[kMaxDepth];
+	int stack_size = 0;
+	std::uint32_t node_index = root_index;
+	bool has_hit = false;
+
+	while (true)
+	{
+		const BvhNode& node = nodes_[node_index];
+		RAYTRACING_STAT(node_visits, 1);
+		if (node.IsLeaf())
+		{
+			for (std::uint32_t i = 0; i < node.primitive_count; ++i)
+			{
+				if (intersect(primitive_indices_[node.left_first + i], distance))
+				{
+					has_hit = true;
+				}
+			}
+		}
+		else
+		{
+			std::uint32_t near_index = node.left_first;
+			std::uint32_t far_index = node.left_first + 1;
+			float near_distance = IntersectNode(nodes_[near_index], ray, distance);
+			float far_distance = IntersectNode(nodes_[far_index], ray, distance);
+			if (far_distance < near_distance)
+			{
+				std::swap(near_index, far_index);
+				std::swap(near_distance, far_distance);
+			}
+			if (near_distance != kMiss)
+			{
+				if (far_distance != kMiss)
+				{
+					stack[stack_size++] = { far_index, far_distance };
+				}
+				node_index = near_index;
+				continue;
+			}
+		}
+
+		// Pop the next node, skipping the ones behind the closest hit so far
+		bool found = false;
+		while (stack_size > 0)
+		{
+			const auto [next_index, next_distance] = stack[--stack_size];
+			if (next_distance < distance)
+			{
+				node_index = next_index;
+				found = true;
+				break;
+			}
+		}
+		if (!found)
+		{
+			break;
+		}
+	}
+	return has_hit;
+}
+
+template<typename OcclusionFunc>
+bool Bvh::Occluded(
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float max_distance,
+	OcclusionFunc&& occluded) const
+{
+	if (nodes_.empty())
+	{
+		return false;
+	}
+	const maths::SlabRay3 ray(origin, direction);
+	if (IntersectNode(nodes_[0], ray, max_distance) == kMiss)
+	{
+		return false;
+	}
+
+	// Any hit ends the query, so the children are not sorted
+	std::uint32_t stack[kMaxDepth];
+	int stack_size = 0;
+	std::uint32_t node_index = 0;
+	while (true)
+	{
+		const BvhNode& node = nodes_[node_index];
+		RAYTRACING_STAT(node_visits, 1);
+		if (node.IsLeaf())
+		{
+			for (std::uint32_t i = 0; i < node.primitive_count; ++i)
+			{
+				if (occluded(primitive_indices_[node.left_first + i]))
+				{
+					return true;
+				}
+			}
+		}
+		else
+		{
+			const std::uint32_t left_index = node.left_first;
+			const std::uint32_t right_index = node.left_first + 1;
+			const bool left_hit = IntersectNode(nodes_[left_index], ray, max_distance) != kMiss;
+			const bool right_hit = IntersectNode(nodes_[right_index], ray, max_distance) != kMiss;
+			if (left_hit || right_hit)
+			{
+				if (left_hit && right_hit)
+				{
+					stack[stack_size++] = right_index;
+				}
+				node_index = left_hit ? left_index : right_index;
+				continue;
+			}
+		}
+
+		if (stack_size == 0)
+		{
+			break;
+		}
+		node_index = stack[--stack_size];
+	}
+	return false;
+}
+
+template<typename IntersectFunc>
+void Bvh::IntersectPacket(
+	const RayPacket& packet,
+	PacketHit& hit,
+	int active_mask,
+	IntersectFunc&& intersect) const
+{
+	if (nodes_.empty())
+	{
+		return;
+	}
+	float entry_distance;
+	int mask = IntersectBoxPacket(nodes_[0].bounds_min, nodes_[0].bounds_max,
+		packet, hit, active_mask, entry_distance);
+	if (mask == 0)
+	{
+		return;
+	}
+
+	// Far children waiting to be visited, with the rays entering them
+	struct StackEntry {
+		std::uint32_t node_index;
+		float entry_distance;
+		int mask;
+	};
+	StackEntry stack[kMaxDepth];
+	int stack_size = 0;
+	std::uint32_t node_index = 0;
+	while (true)
+	{
+		const BvhNode& node = nodes_[node_index];
+		RAYTRACING_STAT(node_visits, 1);
+		if (node.IsLeaf())
+		{
+			for (std::uint32_t i = 0; i < node.primitive_count; ++i)
+			{
+				intersect(primitive_indices_[node.left_first + i], mask);
+			}
+		}
+		else if ((mask & (mask - 1)) == 0)
+		{
+			// A single ray is left, a scalar traversal of the subtree is cheaper
+			int lane = 0;
+			while (mask != (1 << lane))
+			{
+				++lane;
+			}
+			float distance = hit.distance[lane];
+			IntersectFrom(node_index, packet.origin(lane), packet.direction(lane), distance,
+				[&](std::uint32_t primitive, float& closest_distance)
+				{
+					if (intersect(primitive, mask) == 0)
+					{
+						return false;
+					}
+					closest_distance = hit.distance[lane];
+					return true;
+				});
+		}
+		else
+		{
+			std::uint32_t near_index = node.left_first;
+			std::uint32_t far_index = node.left_first + 1;
+			float near_distance;
+			float far_distance;
+			int near_mask = IntersectBoxPacket(nodes_[near_index].bounds_min, nodes_[near_index].bounds_max,
+				packet, hit, mask, near_distance);
+			int far_mask = IntersectBoxPacket(nodes_[far_index].bounds_min, nodes_[far_index].bounds_max,
+				packet, hit, mask, far_distance);
+			if (far_distance < near_distance)
+			{
+				std::swap(near_index, far_index);
+				std::swap(near_distance, far_distance);
+				std::swap(near_mask, far_mask);
+			}
+			if (near_mask != 0)
+			{
+				if (far_mask != 0)
+				{
+					stack[stack_size++] = { far_index, far_distance, far_mask };
+				}
+				node_index = near_index;
+				mask = near_mask;
+				continue;
+			}
+		}
+
+		// Pop the next node, skipping the ones behind the hits of all its rays
+		bool found = false;
+		while (stack_size > 0)
+		{
+			const StackEntry& entry = stack[--stack_size];
+			float farthest_hit = 0.0f;
+			for (int lane = 0; lane < kPacketSize; ++lane)
+			{
+				if ((entry.mask & (1 << lane)) && hit.distance[lane] > farthest_hit)
+				{
+					farthest_hit = hit.distance[lane];
+				}
+			}
+			if (entry.entry_distance < farthest_hit)
+			{
+				node_index = entry.node_index;
+				mask = entry.mask;
+				found = true;
+				break;
+			}
+		}
+		if (!found)
+		{
+			break;
+		}
+	}
+}
+
+}// namespace raytracing
@@ -0,0 +1,104 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "maths/angle.h"
+#include "maths/frustum.h"
+#include "maths/matrix4.h"
+#include "maths/vector3.h"
+
+namespace raytracing {
+
+// Pinhole camera looking down its local -Z axis with +Y up. The orientation
+// is a rotation whose columns, the Vector4f of the matrix, are the camera
+// axes, as for the transforms of the instances.
+class Camera {
+public:
+	Camera() = default;
+	Camera(
+		const maths::Vector3f& position,
+		const maths::Matrix4f& orientation,
+		maths::radian_t fov,
+		float aspect);
+
+	//Precompute the mapping from the pixels of an image to the ray
+	//directions, needed after any change of the camera or of the image size
+	void Prepare(int width, int height);
+
+	//Start of the rays of a row, y being measured in pixels from the top
+	//of the image. Ray directions of the row are then one multiply-add away.
+	maths::Vector3f RowStart(float y) const { return top_left_ + pixel_down_ * y; }
+
+	//Not normalized direction of the ray through the point x of a row
+	maths::Vector3f RowDirection(const maths::Vector3f& row_start, float x) const
+	{
+		return row_start + pixel_right_ * x;
+	}
+
+	//Normalized direction of the ray through a point of the image, in pixels
+	maths::Vector3f RayDirection(float x, float y) const
+	{
+		return RowDirection(RowStart(y), x).Normalized();
+	}
+
+	//Volume seen by the camera between two distances, for culling.
+	//Call Prepare before.
+	maths::Frustum frustum(float near_distance, float far_distance) const;
+
+	const maths::Vector3f& position() const { return position_; }
+	void set_position(const maths::Vector3f& position) { position_ = position; }
+
+	const maths::Matrix4f& orientation() const { return orientation_; }
+	void set_orientation(const maths::Matrix4f& orientation) { orientation_ = orientation; }
+
+	maths::radian_t fov() const { return fov_; }
+	void set_fov(maths::radian_t fov) { fov_ = fov; }
+
+	//Width over height of the image plane, 0 takes the one of the image
+	float aspect() const { return aspect_; }
+	void set_aspect(float aspect) { aspect_ = aspect; }
+
+	const maths::Vector3f& right() const { return right_; }
+	const maths::Vector3f& up() const { return up_; }
+	const maths::Vector3f& forward() const { return forward_; }
+
+private:
+	maths::Vector3f position_{ 0.0f, 0.0f, 0.0f };
+	maths::Matrix4f orientation_ = maths::Matrix4f::identity();
+	//Vertical field of view
+	maths::radian_t fov_{ 1.0f };
+	float aspect_ = 0.0f;
+
+	maths::Vector3f right_{ 1.0f, 0.0f, 0.0f };
+	maths::Vector3f up_{ 0.0f, 1.0f, 0.0f };
+	maths::Vector3f forward_{ 0.0f, 0.0f, -1.0f };
+	//Half size of the image plane at a distance of 1
+	float half_width_ = 1.0f;
+	float half_height_ = 1.0f;
+	maths::Vector3f top_left_{ -1.0f, 1.0f, -1.0f };
+	maths::Vector3f pixel_right_{ 1.0f, 0.0f, 0.0f };
+	maths::Vector3f pixel_down_{ 0.0f, -1.0f, 0.0f };
+};
+
+}// namespace raytracing
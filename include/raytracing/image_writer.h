@@ -0,0 +1,84 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maths/vector3.h"
+
+namespace raytracing {
+
+// Convert colors in [0, 255] to 8-bit RGB, values outside are clamped.
+// The conversion runs over the flat array of components so it vectorizes.
+void ConvertToRgb8(std::span<const maths::Vector3f> colors, std::vector<std::uint8_t>& rgb);
+
+// Write an 8-bit RGB image as a binary .ppm with a single write of the pixels.
+// Return false if the file could not be written.
+bool WritePpm(const std::string& path, int width, int height, std::span<const std::uint8_t> rgb);
+
+// Thread writing images in the background, so a frame can be rendered
+// while the previous one is written to disk
+class AsyncImageWriter {
+public:
+	AsyncImageWriter();
+	// Write the images still waiting before stopping the thread
+	~AsyncImageWriter();
+
+	AsyncImageWriter(const AsyncImageWriter&) = delete;
+	AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+
+	// Queue an image to be written as a .ppm, the pixels are moved to the writer
+	void Write(std::string path, int width, int height, std::vector<std::uint8_t>&& rgb);
+
+	// Wait until every queued image is written, return false if one of them failed
+	bool Flush();
+
+private:
+	struct Job {
+		std::string path;
+		int width;
+		int height;
+		std::vector<std::uint8_t> rgb;
+	};
+
+	void WriterLoop();
+
+	std::mutex mutex_;
+	std::condition_variable job_condition_;
+	std::condition_variable done_condition_;
+	std::deque<Job> jobs_;
+	bool writing_ = false;
+	bool failed_ = false;
+	bool stop_ = false;
+	std::thread thread_;
+};
+
+}// namespace raytracing
@@ -0,0 +1,147 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include "maths/aabb3.h"
+#include "maths/matrix4.h"
+#include "maths/vector3.h"
+#include "raytracing/bvh.h"
+#include "raytracing/render_stats.h"
+#include "raytracing/sphere_arrays.h"
+#include "raytracing/triangle_mesh.h"
+
+namespace raytracing {
+
+// The transforms of the instances are affine and use the column convention
+// of maths::Matrix4f: TransformPoint(m, p) is m * Vector4f(p, 1), the
+// translation being the last column as built by translationMatrix.
+inline maths::Vector3f TransformPoint(const maths::Matrix4f& transform, const maths::Vector3f& point)
+{
+	return {
+		transform[0].x * point.x + transform[1].x * point.y + transform[2].x * point.z + transform[3].x,
+		transform[0].y * point.x + transform[1].y * point.y + transform[2].y * point.z + transform[3].y,
+		transform[0].z * point.x + transform[1].z * point.y + transform[2].z * point.z + transform[3].z };
+}
+
+inline maths::Vector3f TransformDirection(const maths::Matrix4f& transform, const maths::Vector3f& direction)
+{
+	return {
+		transform[0].x * direction.x + transform[1].x * direction.y + transform[2].x * direction.z,
+		transform[0].y * direction.x + transform[1].y * direction.y + transform[2].y * direction.z,
+		transform[0].z * direction.x + transform[1].z * direction.y + transform[2].z * direction.z };
+}
+
+// Normals are transformed by the transpose of the inverse transform
+inline maths::Vector3f TransformNormal(const maths::Matrix4f& inverse_transform, const maths::Vector3f& normal)
+{
+	return maths::Vector3f(
+		inverse_transform[0].x * normal.x + inverse_transform[0].y * normal.y + inverse_transform[0].z * normal.z,
+		inverse_transform[1].x * normal.x + inverse_transform[1].y * normal.y + inverse_transform[1].z * normal.z,
+		inverse_transform[2].x * normal.x + inverse_transform[2].y * normal.y + inverse_transform[2].z * normal.z)
+		.Normalized();
+}
+
+// Inverse of an affine transform, its last row is taken as 0 0 0 1
+maths::Matrix4f AffineInverse(const maths::Matrix4f& transform);
+
+// Box holding the given box once transformed
+maths::AABB3 TransformBounds(const maths::Matrix4f& transform, const maths::AABB3& bounds);
+
+// Spheres and triangles share one index space, the triangles
+// being numbered after the spheres
+inline bool IntersectPrimitive(
+	const SphereArrays& spheres,
+	const TriangleMesh& triangles,
+	std::uint32_t index,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance)
+{
+	RAYTRACING_STAT(intersection_tests, 1);
+	if (index < spheres.size())
+	{
+		return IntersectSphere(spheres, index, origin, direction, distance);
+	}
+	return IntersectTriangle(triangles, index - spheres.size(), origin, direction, distance);
+}
+
+// Geometry placed in the scene by instances, stored once in object space
+// with its own hierarchy. The materials are indices in the material table
+// of the scene.
+struct Model {
+	SphereArrays spheres;
+	TriangleMesh triangles;
+	std::uint32_t triangle_material_index = 0;
+	Bvh bvh;
+	maths::AABB3 bounds;
+
+	std::uint32_t primitive_count() const
+	{
+		return static_cast<std::uint32_t>(spheres.size() + triangles.triangle_count());
+	}
+
+	// Build the hierarchy and the bounds once the geometry is set, the
+	// spheres being put in the order of the leaves
+	void Build();
+
+	// Closest hit in object space, the direction being normalized
+	bool Intersect(
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float& distance,
+		std::uint32_t& primitive) const;
+
+	bool Occluded(
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float max_distance) const;
+
+	// Bytes used by the geometry and its hierarchy
+	std::size_t memory_size() const;
+};
+
+// Placement of a model in the scene
+struct Instance {
+	std::uint32_t model = 0;
+	// Object to world transform
+	maths::Matrix4f transform = maths::Matrix4f::identity();
+	// World to object transform, used to bring the rays in object space
+	maths::Matrix4f inverse_transform = maths::Matrix4f::identity();
+	// Bounds of the model in world space
+	maths::AABB3 bounds;
+
+	// Set the transform with its inverse and the bounds of the model it places
+	void SetTransform(const maths::Matrix4f& object_to_world, const Model& placed_model);
+};
+
+// Primitive of a model hit through an instance
+struct InstanceHit {
+	std::uint32_t instance = 0;
+	std::uint32_t primitive = 0;
+};
+
+}// namespace raytracing
@@ -0,0 +1,80 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "maths/vector3.h"
+#include "raytracing/bvh.h"
+
+namespace raytracing {
+
+struct PointLight {
+	// Radius of a light whose intensity does not fade with distance
+	static constexpr float kNoFalloff = std::numeric_limits<float>::infinity();
+
+	maths::Vector3f position{ 10.0f,10.0f,0.0f };
+	float intensity = 1.0f;
+	// Distance at which the received light is halved, must be positive
+	float falloff_radius = kNoFalloff;
+
+	// Part of the intensity reaching a point at the given squared distance
+	static float Attenuation(float squared_distance, float falloff_radius)
+	{
+		return 1.0f / (1.0f + squared_distance / (falloff_radius * falloff_radius));
+	}
+};
+
+// Hierarchy over the lights of a scene, used to pick the lights that matter
+// the most for a point without looking at all of them. Each node stores the
+// total intensity of its lights, so the importance of a whole subtree is
+// estimated from its bounds only.
+class LightTree {
+public:
+	void Build(std::span<const PointLight> lights);
+
+	bool empty() const { return lights_.empty(); }
+	std::size_t size() const { return lights_.size(); }
+
+	// Pick a light with a probability proportional to its estimated
+	// contribution at position, u being a random number in [0, 1).
+	// Return the index of the light and set pdf to its probability.
+	std::uint32_t Sample(const maths::Vector3f& position, float u, float& pdf) const;
+
+private:
+	// Upper bound of the light received at position from a node
+	float NodeImportance(std::uint32_t node_index, const maths::Vector3f& position) const;
+	float LightImportance(std::uint32_t light_index, const maths::Vector3f& position) const;
+
+	std::vector<PointLight> lights_;
+	Bvh bvh_;
+	// Sum of the intensities and largest falloff radius of the lights under each node
+	std::vector<float> node_intensities_;
+	std::vector<float> node_falloff_radii_;
+};
+
+}// namespace raytracing
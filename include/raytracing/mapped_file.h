@@ -0,0 +1,69 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace raytracing {
+
+// Read only view of a whole file mapped in memory, the pages are only
+// read from the disk when they are accessed
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// How the pages are going to be read, given to the system as a hint
+	enum class Access {
+		kSequential,
+		kRandom
+	};
+
+	// Map the file at path, return false if it could not be opened or mapped
+	bool Open(const std::string& path, Access access = Access::kSequential);
+	void Close();
+
+	bool is_open() const { return is_open_; }
+	std::size_t size() const { return size_; }
+	const char* data() const { return data_; }
+	std::string_view view() const { return { data_, size_ }; }
+
+private:
+	const char* data_ = nullptr;
+	std::size_t size_ = 0;
+	bool is_open_ = false;
+#ifdef _WIN32
+	void* file_handle_ = nullptr;
+	void* mapping_handle_ = nullptr;
+#endif
+};
+
+}// namespace raytracing
@@ -0,0 +1,250 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "maths/vector3.h"
+
+// SSE2 is part of every x86-64 target, other targets use the scalar loops
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYTRACING_SSE
+#include <emmintrin.h>
+#endif
+
+namespace raytracing {
+
+constexpr int kPacketSize = 4;
+constexpr int kPacketFullMask = (1 << kPacketSize) - 1;
+
+// Rays traced together, stored component by component so that a single
+// SSE register holds the same component of every ray of the packet
+struct alignas(16) RayPacket {
+	float origin_x[kPacketSize];
+	float origin_y[kPacketSize];
+	float origin_z[kPacketSize];
+	float direction_x[kPacketSize];
+	float direction_y[kPacketSize];
+	float direction_z[kPacketSize];
+	float inv_direction_x[kPacketSize];
+	float inv_direction_y[kPacketSize];
+	float inv_direction_z[kPacketSize];
+
+	void Set(int lane, const maths::Vector3f& origin, const maths::Vector3f& direction)
+	{
+		origin_x[lane] = origin.x;
+		origin_y[lane] = origin.y;
+		origin_z[lane] = origin.z;
+		direction_x[lane] = direction.x;
+		direction_y[lane] = direction.y;
+		direction_z[lane] = direction.z;
+		inv_direction_x[lane] = 1.0f / direction.x;
+		inv_direction_y[lane] = 1.0f / direction.y;
+		inv_direction_z[lane] = 1.0f / direction.z;
+	}
+
+	maths::Vector3f origin(int lane) const { return { origin_x[lane], origin_y[lane], origin_z[lane] }; }
+	maths::Vector3f direction(int lane) const { return { direction_x[lane], direction_y[lane], direction_z[lane] }; }
+};
+
+// Closest hit of each ray of a packet, primitive is -1 when nothing was hit
+struct alignas(16) PacketHit {
+	float distance[kPacketSize];
+	std::int32_t primitive[kPacketSize];
+
+	void Reset(float max_distance)
+	{
+		for (int lane = 0; lane < kPacketSize; ++lane)
+		{
+			distance[lane] = max_distance;
+			primitive[lane] = -1;
+		}
+	}
+};
+
+// Return the mask of the active rays entering the box before their current hit,
+// entry_distance is set to the smallest entry distance of these rays
+inline int IntersectBoxPacket(
+	const maths::Vector3f& bounds_min,
+	const maths::Vector3f& bounds_max,
+	const RayPacket& packet,
+	const PacketHit& hit,
+	int active_mask,
+	float& entry_distance)
+{
+#ifdef RAYTRACING_SSE
+	const __m128 origin_x = _mm_load_ps(packet.origin_x);
+	const __m128 origin_y = _mm_load_ps(packet.origin_y);
+	const __m128 origin_z = _mm_load_ps(packet.origin_z);
+	const __m128 inv_x = _mm_load_ps(packet.inv_direction_x);
+	const __m128 inv_y = _mm_load_ps(packet.inv_direction_y);
+	const __m128 inv_z = _mm_load_ps(packet.inv_direction_z);
+
+	const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds_min.x), origin_x), inv_x);
+	const __m128 tx2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds_max.x), origin_x), inv_x);
+	__m128 tmin = _mm_min_ps(tx1, tx2);
+	__m128 tmax = _mm_max_ps(tx1, tx2);
+	const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds_min.y), origin_y), inv_y);
+	const __m128 ty2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds_max.y), origin_y), inv_y);
+	tmin = _mm_max_ps(tmin, _mm_min_ps(ty1, ty2));
+	tmax = _mm_min_ps(tmax, _mm_max_ps(ty1, ty2));
+	const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds_min.z), origin_z), inv_z);
+	const __m128 tz2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds_max.z), origin_z), inv_z);
+	tmin = _mm_max_ps(tmin, _mm_min_ps(tz1, tz2));
+	tmax = _mm_min_ps(tmax, _mm_max_ps(tz1, tz2));
+
+	const __m128 hit_mask = _mm_and_ps(
+		_mm_and_ps(_mm_cmpge_ps(tmax, tmin), _mm_cmplt_ps(tmin, _mm_load_ps(hit.distance))),
+		_mm_cmpgt_ps(tmax, _mm_setzero_ps()));
+	const int mask = _mm_movemask_ps(hit_mask) & active_mask;
+	alignas(16) float entries[kPacketSize];
+	_mm_store_ps(entries, tmin);
+	entry_distance = std::numeric_limits<float>::infinity();
+	for (int lane = 0; lane < kPacketSize; ++lane)
+	{
+		if ((mask & (1 << lane)) && entries[lane] < entry_distance)
+		{
+			entry_distance = entries[lane];
+		}
+	}
+	return mask;
+#else
+	int mask = 0;
+	entry_distance = std::numeric_limits<float>::infinity();
+	for (int lane = 0; lane < kPacketSize; ++lane)
+	{
+		if (!(active_mask & (1 << lane)))
+		{
+			continue;
+		}
+		const float tx1 = (bounds_min.x - packet.origin_x[lane]) * packet.inv_direction_x[lane];
+		const float tx2 = (bounds_max.x - packet.origin_x[lane]) * packet.inv_direction_x[lane];
+		float tmin = std::fmin(tx1, tx2);
+		float tmax = std::fmax(tx1, tx2);
+		const float ty1 = (bounds_min.y - packet.origin_y[lane]) * packet.inv_direction_y[lane];
+		const float ty2 = (bounds_max.y - packet.origin_y[lane]) * packet.inv_direction_y[lane];
+		tmin = std::fmax(tmin, std::fmin(ty1, ty2));
+		tmax = std::fmin(tmax, std::fmax(ty1, ty2));
+		const float tz1 = (bounds_min.z - packet.origin_z[lane]) * packet.inv_direction_z[lane];
+		const float tz2 = (bounds_max.z - packet.origin_z[lane]) * packet.inv_direction_z[lane];
+		tmin = std::fmax(tmin, std::fmin(tz1, tz2));
+		tmax = std::fmin(tmax, std::fmax(tz1, tz2));
+		if (tmax >= tmin && tmin < hit.distance[lane] && tmax > 0.0f)
+		{
+			mask |= 1 << lane;
+			entry_distance = std::fmin(entry_distance, tmin);
+		}
+	}
+	return mask;
+#endif
+}
+
+// Intersect the active rays with a sphere and keep the hits closer than
+// the current ones. Same arithmetic as maths::Ray3::IntersectSphere.
+// Return the mask of the rays that got a closer hit.
+inline int IntersectSpherePacket(
+	const maths::Vector3f& center,
+	float radius,
+	std::int32_t primitive,
+	const RayPacket& packet,
+	PacketHit& hit,
+	int active_mask)
+{
+#ifdef RAYTRACING_SSE
+	const __m128 direction_x = _mm_load_ps(packet.direction_x);
+	const __m128 direction_y = _mm_load_ps(packet.direction_y);
+	const __m128 direction_z = _mm_load_ps(packet.direction_z);
+	const __m128 v_x = _mm_sub_ps(_mm_set1_ps(center.x), _mm_load_ps(packet.origin_x));
+	const __m128 v_y = _mm_sub_ps(_mm_set1_ps(center.y), _mm_load_ps(packet.origin_y));
+	const __m128 v_z = _mm_sub_ps(_mm_set1_ps(center.z), _mm_load_ps(packet.origin_z));
+
+	// Distance along the rays to the closest point to the sphere center
+	const __m128 d = _mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(v_x, direction_x), _mm_mul_ps(v_y, direction_y)), _mm_mul_ps(v_z, direction_z));
+	const __m128 v_length2 = _mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(v_x, v_x), _mm_mul_ps(v_y, v_y)), _mm_mul_ps(v_z, v_z));
+	const __m128 squared_distance = _mm_sub_ps(v_length2, _mm_mul_ps(d, d));
+	const __m128 radius2 = _mm_set1_ps(radius * radius);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 q = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(radius2, squared_distance), zero));
+	const __m128 t1 = _mm_sub_ps(d, q);
+	const __m128 t0 = _mm_add_ps(d, q);
+	const __m128 t1_in_front = _mm_cmpge_ps(t1, zero);
+	const __m128 t = _mm_or_ps(_mm_and_ps(t1_in_front, t1), _mm_andnot_ps(t1_in_front, t0));
+
+	const __m128 current_distance = _mm_load_ps(hit.distance);
+	const __m128 closer = _mm_and_ps(
+		_mm_and_ps(_mm_cmpge_ps(d, zero), _mm_cmple_ps(squared_distance, radius2)),
+		_mm_cmplt_ps(t, current_distance));
+	const int mask = _mm_movemask_ps(closer) & active_mask;
+	if (mask == 0)
+	{
+		return 0;
+	}
+	const __m128 lane_mask = _mm_castsi128_ps(_mm_set_epi32(
+		(mask & 8) ? -1 : 0, (mask & 4) ? -1 : 0, (mask & 2) ? -1 : 0, (mask & 1) ? -1 : 0));
+	_mm_store_ps(hit.distance, _mm_or_ps(
+		_mm_and_ps(lane_mask, t), _mm_andnot_ps(lane_mask, current_distance)));
+	const __m128i primitives = _mm_load_si128(reinterpret_cast<const __m128i*>(hit.primitive));
+	const __m128i lane_mask_i = _mm_castps_si128(lane_mask);
+	_mm_store_si128(reinterpret_cast<__m128i*>(hit.primitive), _mm_or_si128(
+		_mm_and_si128(lane_mask_i, _mm_set1_epi32(primitive)),
+		_mm_andnot_si128(lane_mask_i, primitives)));
+	return mask;
+#else
+	int mask = 0;
+	const float radius2 = radius * radius;
+	for (int lane = 0; lane < kPacketSize; ++lane)
+	{
+		if (!(active_mask & (1 << lane)))
+		{
+			continue;
+		}
+		const float v_x = center.x - packet.origin_x[lane];
+		const float v_y = center.y - packet.origin_y[lane];
+		const float v_z = center.z - packet.origin_z[lane];
+		const float d = v_x * packet.direction_x[lane] + v_y * packet.direction_y[lane]
+			+ v_z * packet.direction_z[lane];
+		const float squared_distance = (v_x * v_x + v_y * v_y + v_z * v_z) - d * d;
+		if (d < 0.0f || squared_distance > radius2)
+		{
+			continue;
+		}
+		const float q = std::sqrt(radius2 - squared_distance);
+		const float t = d - q >= 0.0f ? d - q : d + q;
+		if (t < hit.distance[lane])
+		{
+			hit.distance[lane] = t;
+			hit.primitive[lane] = primitive;
+			mask |= 1 << lane;
+		}
+	}
+	return mask;
+#endif
+}
+
+}// namespace raytracing
@@ -23,17 +23,48 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
 #include <vector>
 
+#include "thread_pool.h"
 #include "maths/vector3.h"
 #include "maths/sphere.h"
 #include "maths/ray3.h"
 #include "maths/plane.h"
+#include "raytracing/bvh.h"
+#include "raytracing/camera.h"
+#include "raytracing/image_writer.h"
+#include "raytracing/instance.h"
+#include "raytracing/light_tree.h"
+#include "raytracing/material.h"
+#include "raytracing/ray_packet.h"
+#include "raytracing/render_stats.h"
+#include "raytracing/scene_file.h"
+#include "raytracing/sphere_arrays.h"
+#include "raytracing/triangle_mesh.h"
 
 namespace raytracing {
 
-struct PointLight {
-	maths::Vector3f position{ 10.0f,10.0f,0.0f };
+// Structure used to find the objects hit by a ray
+enum class Acceleration {
+	kBruteForce,
+	kBvh
+};
+
+// How the primary rays are traced
+enum class RenderMode {
+	// One ray at a time
+	kScalar,
+	// Packets of 2x2 pixels intersected together with SIMD,
+	// secondary rays are then traced one at a time
+	kPacket
 };
 
 struct HitInfos
@@ -41,74 +72,405 @@ struct HitInfos
 	maths::Vector3f normal;
 	maths::Vector3f hit_position;
 	float distance;
+	//Entry of the material table, only read once the closest hit is known
+	std::uint32_t material_index;
+};
+
+// Time spent rendering one tile of the image
+struct TileStats
+{
+	int x;
+	int y;
+	int width;
+	int height;
+	double milliseconds;
+	//Work done in the tile, only counted with RAYTRACING_STATS
+	RenderStats counters;
 };
 
 class Raytracer {
 public:
 	Raytracer() = default;
-	//Set bases value and variable for raytracer rendering
+	//Set bases value and variable for raytracer rendering.
+	//The spheres are only read to fill the scene arrays, the planes and the
+	//material table indexed by the spheres and planes are copied.
 	void SetScene(
-		std::vector<maths::Sphere>& spheres,
-		std::vector<maths::Plane>& planes,
+		std::span<const maths::Sphere> spheres,
+		std::span<const maths::Plane> planes,
+		std::span<const Material> materials,
 		const PointLight light,
 		const int& heigth,
 		const int& width,
 		const float& fov,
-		const double& bias)
-	{
-		spheres_ = spheres;
-		planes_ = planes;
-		light_ = light;
-		height_ = heigth;
-		width_ = width;
-		fov_ = fov;
-		int total = width_ * height_;
-		frame_buffer_ = std::vector<maths::Vector3f>(total);
-		bias_ = bias;
-	}
+		const double& bias);
+
+	//Same as above, the planes and materials are moved into the scene
+	void SetScene(
+		std::span<const maths::Sphere> spheres,
+		std::vector<maths::Plane>&& planes,
+		std::vector<Material>&& materials,
+		const PointLight light,
+		const int& heigth,
+		const int& width,
+		const float& fov,
+		const double& bias);
+
+	//Set a scene whose spheres are already stored as arrays,
+	//the arrays, materials and planes are moved into the scene
+	void SetScene(
+		SphereArrays&& spheres,
+		std::vector<Material>&& materials,
+		std::vector<maths::Plane>&& planes,
+		const PointLight light,
+		const int& heigth,
+		const int& width,
+		const float& fov,
+		const double& bias);
+
+	//Set the whole scene stored in a binary scene file: the arrays are
+	//copied as they are and the hierarchy saved with them is used as it is.
+	//The raytracer owns its copy, so the file can be closed once loaded and
+	//meshes or models can be added to the scene afterwards.
+	void SetScene(const SceneFile& scene);
 
-	//Cast ray for each pixel to check collision and render objects
+	//Cast ray for each pixel to check collision and render objects,
+	//depth is the number of reflexions that led to this ray
 	maths::Vector3f RayCast(
 		const maths::Vector3f& origin,
 		const maths::Vector3f& ray_direction,
 		const int& depth = 0);
 
-	//Check intersection between the ray and each object in the scene
+	//Check intersection between the ray and each object in the scene and keep
+	//the closest one, the planes being tested after the other objects.
+	//The material of the hit is materials()[hit_infos.material_index].
+	//While rendering without a bvh, a primary ray leaving the camera is
+	//only tested against the primitives inside of the camera frustum.
 	bool ObjectIntersect(
 		maths::Ray3& ray, 
-		Material& hit_material, 
 		HitInfos& hit_infos, 
-		float& distance);
+		float& distance,
+		bool primary_ray = false);
 
-	//Cast a shadow ray to check intersection with objects and render shadows
+	//Return true if any object blocks the ray before max_distance,
+	//without looking for the closest one
+	bool Occluded(
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float max_distance) const;
+
+	//Cast a shadow ray to check intersection with objects and render shadows,
+	//only the objects closer than the light at light_distance can block it
 	bool ShadowRay(
 		const maths::Vector3f& hit_position, 
 		const maths::Vector3f& hit_normal, 
-		const maths::Vector3f& light_normal);
+		const maths::Vector3f& light_normal,
+		float light_distance = std::numeric_limits<float>::infinity());
 		
 	//Calculate reflexion direction for the reflexion ray
 	maths::Vector3f Reflect(
 		const maths::Vector3f& ray_direction, 
 		const maths::Vector3f& hit_normal);
 
-	//Base raytracing function that will start raytracing rendering
+	//Base raytracing function that will start raytracing rendering,
+	//the image is split in tiles shared between the threads of a pool
 	void Render();
 
-	//Write scene result into a .ppm image
-	void WriteImage();
+	//Render into a buffer provided by the caller instead of the frame buffer.
+	//Return false, rendering nothing, if it does not hold width * height colors.
+	bool RenderInto(std::span<maths::Vector3f> output);
+
+	//Clear the samples accumulated by the progressive passes,
+	//done automatically when the scene is set
+	void ResetProgressive();
+
+	//Trace one more sample for every pixel that has not converged yet and
+	//store the mean of each pixel in the frame buffer. The first sample goes
+	//through the center of the pixel, the next ones are jittered inside it.
+	//Return the number of pixels that got a sample.
+	int RenderPass();
+
+	//Render passes until the time budget is spent, max_passes are done or every
+	//pixel has converged. The first pass is always completed, so the frame buffer
+	//holds a whole image. Return the number of passes done.
+	int RenderProgressive(std::chrono::milliseconds time_budget, int max_passes);
+
+	//Number of progressive passes since the last reset
+	int progressive_pass_count() const { return progressive_pass_count_; }
+	//Number of samples accumulated for each pixel
+	std::span<const std::uint32_t> sample_counts() const { return sample_counts_; }
+
+	//A pixel stops getting samples once it has min_samples and the standard
+	//error of its mean luminance is at most variance_threshold color levels
+	std::uint32_t min_samples() const { return min_samples_; }
+	void set_min_samples(std::uint32_t min_samples) { min_samples_ = min_samples; }
+	float variance_threshold() const { return variance_threshold_; }
+	void set_variance_threshold(float variance_threshold) { variance_threshold_ = variance_threshold; }
+
+	//Write the last rendered frame into a .ppm image at the output path,
+	//return false if the image could not be written. With asynchronous
+	//writing the image is queued and written by another thread.
+	bool WriteImage();
+
+	//Wait until every queued image is written, return false if one failed
+	bool FlushImages();
+
+	const std::string& output_path() const { return output_path_; }
+	void set_output_path(const std::string& output_path) { output_path_ = output_path; }
+
+	bool async_write() const { return async_write_; }
+	void set_async_write(bool async_write) { async_write_ = async_write; }
+
+	std::span<const maths::Vector3f> frameBuffer() const { return frame_buffer_; }
+
+	//Add a mesh to the scene given to SetScene, all its triangles use the
+	//same material, added to the material table. The acceleration structure
+	//is built again, so large meshes are better added at once than as many
+	//small ones.
+	void AddMesh(const TriangleMesh& mesh, const Material& material);
+	//Triangles of every mesh of the scene
+	const TriangleMesh& triangles() const { return triangles_; }
+
+	//Add geometry that can be placed many times in the scene through
+	//instances, stored once with its own hierarchy. The spheres index the
+	//material table of the scene, the mesh material is added to it when
+	//the mesh has triangles. Return the model index.
+	std::uint32_t AddModel(
+		std::span<const maths::Sphere> spheres,
+		const TriangleMesh& mesh = {},
+		const Material& mesh_material = {});
+
+	//Place a model in the scene, transform going from the model to the world.
+	//Its columns are the Vector4f of the matrix, the translation being the last one.
+	//Return the instance index.
+	std::uint32_t AddInstance(std::uint32_t model, const maths::Matrix4f& transform);
+	void SetInstanceTransform(std::uint32_t instance, const maths::Matrix4f& transform);
+
+	//Update the hierarchy over the instances after they were added or moved.
+	//Moved instances only refit the bounds of the tree, so it can be done every
+	//frame. Rendering does it when needed, direct queries need it to be called.
+	void UpdateInstances();
+
+	const std::vector<Model>& models() const { return models_; }
+	const std::vector<Instance>& instances() const { return instances_; }
+
+	//Replace the light given to SetScene by several lights
+	void SetLights(std::vector<PointLight>&& lights);
+	std::span<const PointLight> lights() const { return lights_; }
+
+	//Scenes with at most this number of lights cast a shadow ray towards each
+	//of them, above it this number of lights is picked randomly at each hit
+	//with a probability following their estimated contribution.
+	//At least one light is sampled at each hit.
+	int light_sample_count() const { return light_sample_count_; }
+	void set_light_sample_count(int light_sample_count) { light_sample_count_ = std::max(1, light_sample_count); }
 
-	std::vector<maths::Vector3f> frameBuffer() const { return frame_buffer_; }
+	//Spheres of the scene, in the order of the leaves of the hierarchy once built
+	const SphereArrays& spheres() const { return spheres_; }
+	const std::vector<Material>& materials() const { return materials_; }
+
+	Acceleration acceleration() const { return acceleration_; }
+	void set_acceleration(Acceleration acceleration) { acceleration_ = acceleration; }
+
+	//Number of threads used by Render, 0 uses every hardware thread
+	std::size_t thread_count() const { return thread_count_; }
+	void set_thread_count(std::size_t thread_count) { thread_count_ = thread_count; }
+
+	//Number of reflexions followed by a ray before returning the background color
+	int max_depth() const { return max_depth_; }
+	void set_max_depth(int max_depth) { max_depth_ = max_depth; }
+
+	//A path stops once the part of the color its next reflexion can bring
+	//is at most this fraction of it
+	float min_contribution() const { return min_contribution_; }
+	void set_min_contribution(float min_contribution) { min_contribution_ = min_contribution; }
+
+	RenderMode render_mode() const { return render_mode_; }
+	void set_render_mode(RenderMode render_mode) { render_mode_ = render_mode; }
+
+	//Number of rays traced through each pixel by Render. One ray goes through the
+	//center of the pixel, more rays are jittered in a grid of cells covering it.
+	int samples_per_pixel() const { return samples_per_pixel_; }
+	void set_samples_per_pixel(int samples_per_pixel) { samples_per_pixel_ = std::max(1, samples_per_pixel); }
+
+	//Seed of the jitter of the samples, the same seed always gives the same
+	//image whatever the number of threads
+	std::uint64_t sample_seed() const { return sample_seed_; }
+	void set_sample_seed(std::uint64_t sample_seed) { sample_seed_ = sample_seed; }
+
+	//Point of view of the primary rays. SetView places a camera at the origin
+	//looking down -Z with the given fov, set_camera then moves it.
+	const Camera& camera() const { return camera_; }
+	void set_camera(const Camera& camera);
+
+	int tile_size() const { return tile_size_; }
+	void set_tile_size(int tile_size) { tile_size_ = tile_size; }
+
+	//Timing of each tile of the last Render call
+	const std::vector<TileStats>& tile_stats() const { return tile_stats_; }
+
+	//Counters of the last frame or progressive pass, the sum of the tiles
+	//with the time of the whole frame. Always zero without RAYTRACING_STATS.
+	const RenderStats& render_stats() const { return render_stats_; }
 
 private:
+	//Store the spheres as arrays, with their material index
+	void SetSpheres(std::span<const maths::Sphere> spheres);
+
+	//Set the light and the image, remove the meshes and instances of the previous scene,
+	//then build the acceleration structure unless the caller provides it
+	void SetView(
+		const PointLight& light,
+		int heigth,
+		int width,
+		float fov,
+		double bias,
+		bool build_bvh = true);
+
+	//Sum the light received at a hit from the visible lights,
+	//return false if no light reaches it
+	bool DirectLight(const HitInfos& hit_info, float& light_value);
+
+	//Keep the spheres and triangles inside of the camera frustum, the only
+	//ones primary rays can hit, before rendering a frame without a bvh
+	void CullPrimitives();
+
+	//Spheres and triangles share one index space, the triangles
+	//being numbered after the spheres
+	std::uint32_t PrimitiveCount() const
+	{
+		return static_cast<std::uint32_t>(spheres_.size() + triangles_.triangle_count());
+	}
+	bool IntersectPrimitive(
+		std::uint32_t index,
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float& distance) const;
+	//Fill the position, normal and material index of the hit of a primitive
+	//at hit_info.distance
+	void ResolveHit(
+		std::uint32_t index,
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		HitInfos& hit_info) const;
+
+	//Closest plane hit closer than distance
+	bool IntersectPlanes(
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float& distance,
+		std::uint32_t& plane_index) const;
+	void ResolvePlaneHit(
+		std::uint32_t plane_index,
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		HitInfos& hit_info) const;
+
+	//Closest hit among the instances, closer than distance
+	bool IntersectInstances(
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float& distance,
+		InstanceHit& instance_hit) const;
+	bool OccludedByInstances(
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		float max_distance) const;
+	void ResolveInstanceHit(
+		const InstanceHit& instance_hit,
+		const maths::Vector3f& origin,
+		const maths::Vector3f& direction,
+		HitInfos& hit_info) const;
+
+	//Build the bounding volume hierarchy over the spheres and triangles of the scene
+	void BuildBvh();
+
+	//Compute the color of a ray from its first hit, following its reflexions
+	//iteratively while they still contribute to the color
+	maths::Vector3f TracePath(
+		maths::Vector3f ray_direction,
+		HitInfos hit_info,
+		int depth);
+
+	//Direction of the primary ray going through the center of a pixel
+	maths::Vector3f PrimaryRayDirection(int row, int column) const;
+	//Direction of the primary ray going through the given point of a pixel,
+	//offsets are in [0, 1) from its top left corner
+	maths::Vector3f PrimaryRayDirection(int row, int column, float offset_x, float offset_y) const;
+
+	//Split the image in tiles and call render_tile for each of them
+	//on the thread pool, timing each tile
+	void RunTiles(const std::function<void(const TileStats&)>& render_tile);
+
+	//Cast the primary rays of the pixels of a tile
+	void RenderTile(const TileStats& tile);
+
+	//Trace samples_per_pixel rays through each pixel of a tile
+	void RenderTileSupersampled(const TileStats& tile);
+
+	//Add one sample to the pixels of a tile which have not converged,
+	//return the number of pixels that got a sample
+	int RenderTilePass(const TileStats& tile);
+
+	bool IsPixelConverged(std::size_t pixel) const;
+
+	//Cast the primary rays of a tile by packets of 2x2 pixels
+	void RenderTilePackets(const TileStats& tile);
+
+	//Trace the active rays of a packet and return the color of each ray
+	void TracePacket(const RayPacket& packet, int active_mask, maths::Vector3f* colors);
+
 	maths::Vector3f background_color_{ 150.0f,200.0f,255.0f };
-	std::vector<maths::Sphere> spheres_;
+	SphereArrays spheres_;
+	std::vector<Material> materials_;
 	std::vector<maths::Plane> planes_;
-	PointLight light_;
+	TriangleMesh triangles_;
+	// First triangle and material of each mesh
+	std::vector<std::uint32_t> mesh_first_triangles_;
+	std::vector<std::uint32_t> mesh_material_indices_;
+	std::vector<Model> models_;
+	std::vector<Instance> instances_;
+	// Hierarchy over the bounds of the instances
+	Bvh instance_bvh_;
+	std::vector<maths::AABB3> instance_bounds_;
+	bool instances_changed_ = false;
+	std::vector<std::uint32_t> visible_primitives_;
+	bool primary_rays_culled_ = false;
+	std::vector<PointLight> lights_;
+	LightTree light_tree_;
+	int light_sample_count_ = 8;
 	int height_;
 	int width_;
-	float fov_;
+	Camera camera_;
 	std::vector<maths::Vector3f> frame_buffer_;
+	// Buffer written by the tiles of the current frame
+	std::span<maths::Vector3f> render_target_;
 	double bias_;
+	Acceleration acceleration_ = Acceleration::kBvh;
+	Bvh bvh_;
+	int max_depth_ = 4;
+	// Half of a color level out of 255
+	float min_contribution_ = 0.5f / 255.0f;
+	RenderMode render_mode_ = RenderMode::kScalar;
+	std::size_t thread_count_ = 0;
+	int tile_size_ = 16;
+	std::unique_ptr<threading::ThreadPool> thread_pool_;
+	std::vector<TileStats> tile_stats_;
+	RenderStats render_stats_;
+	std::string output_path_ = "./image.ppm";
+	bool async_write_ = false;
+	std::vector<std::uint8_t> image_;
+	std::unique_ptr<AsyncImageWriter> image_writer_;
+
+	// Progressive rendering state, one entry per pixel
+	std::vector<maths::Vector3f> accumulation_;
+	std::vector<float> luminance_sum_;
+	std::vector<float> luminance_square_sum_;
+	std::vector<std::uint32_t> sample_counts_;
+	int progressive_pass_count_ = 0;
+	std::uint32_t min_samples_ = 4;
+	int samples_per_pixel_ = 1;
+	std::uint64_t sample_seed_ = 0;
+	float variance_threshold_ = 1.0f;
 	};
 	
 }// namespace raytracing
\ No newline at end of file
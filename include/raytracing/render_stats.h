@@ -0,0 +1,92 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+
+namespace raytracing {
+
+// Counters of the work done to render a frame or a tile. They are only
+// collected when the library is built with RAYTRACING_STATS defined
+// (cmake -DRAYTRACING_STATS=ON), otherwise they stay at zero and the
+// counting compiles to nothing.
+struct RenderStats
+{
+	std::uint64_t primary_rays = 0;
+	std::uint64_t shadow_rays = 0;
+	std::uint64_t reflection_rays = 0;
+	// Ray against sphere, triangle or plane tests
+	std::uint64_t intersection_tests = 0;
+	// Nodes of the hierarchies reached by the traversals
+	std::uint64_t node_visits = 0;
+	double milliseconds = 0.0;
+
+	std::uint64_t ray_count() const { return primary_rays + shadow_rays + reflection_rays; }
+
+	double rays_per_second() const
+	{
+		return milliseconds > 0.0 ? static_cast<double>(ray_count()) * 1000.0 / milliseconds : 0.0;
+	}
+
+	double intersection_tests_per_ray() const
+	{
+		const std::uint64_t rays = ray_count();
+		return rays > 0 ? static_cast<double>(intersection_tests) / static_cast<double>(rays) : 0.0;
+	}
+
+	RenderStats& operator+=(const RenderStats& other)
+	{
+		primary_rays += other.primary_rays;
+		shadow_rays += other.shadow_rays;
+		reflection_rays += other.reflection_rays;
+		intersection_tests += other.intersection_tests;
+		node_visits += other.node_visits;
+		milliseconds += other.milliseconds;
+		return *this;
+	}
+};
+
+#ifdef RAYTRACING_STATS
+constexpr bool kRenderStatsEnabled = true;
+#else
+constexpr bool kRenderStatsEnabled = false;
+#endif
+
+// Counters of the calling thread, each thread counting on its own so the
+// workers never share a cache line. The raytracer reads them after each
+// tile and merges the tiles at the end of the frame.
+inline RenderStats& ThreadRenderStats()
+{
+	thread_local RenderStats stats;
+	return stats;
+}
+
+}// namespace raytracing
+
+#ifdef RAYTRACING_STATS
+#define RAYTRACING_STAT(counter, amount) \
+	(::raytracing::ThreadRenderStats().counter += static_cast<std::uint64_t>(amount))
+#else
+#define RAYTRACING_STAT(counter, amount) ((void)0)
+#endif
@@ -0,0 +1,92 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace raytracing {
+
+// Small PCG random generator. Every pixel sample seeds its own generator
+// from its coordinates, so the samples do not depend on the thread tracing them.
+class Rng {
+public:
+	explicit Rng(std::uint64_t seed)
+	{
+		state_ = 0;
+		NextUint();
+		state_ += seed;
+		NextUint();
+	}
+
+	std::uint32_t NextUint()
+	{
+		const std::uint64_t old_state = state_;
+		state_ = old_state * 6364136223846793005ull + kIncrement;
+		const auto xorshifted = static_cast<std::uint32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+		const auto rotation = static_cast<std::uint32_t>(old_state >> 59u);
+		return (xorshifted >> rotation) | (xorshifted << ((32u - rotation) & 31u));
+	}
+
+	// Return a float in [0, 1)
+	float NextFloat()
+	{
+		// The 24 high bits fill exactly the mantissa of a float
+		return static_cast<float>(NextUint() >> 8) * (1.0f / 16777216.0f);
+	}
+
+private:
+	static constexpr std::uint64_t kIncrement = 1442695040888963407ull;
+	std::uint64_t state_;
+};
+
+// Mix the given values into a seed with good bit dispersion
+inline std::uint64_t HashSeed(std::uint64_t a, std::uint64_t b, std::uint64_t c = 0)
+{
+	std::uint64_t hash = a * 0x9E3779B97F4A7C15ull;
+	hash ^= b + 0x632BE59BD9B4E019ull + (hash << 6) + (hash >> 2);
+	hash ^= c + 0x85157AF5D2F3ECB1ull + (hash << 6) + (hash >> 2);
+	// Final avalanche of splitmix64
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+	return hash ^ (hash >> 31);
+}
+
+// Grid of exactly count cells over a pixel, each sample of the pixel is
+// jittered inside its own cell so the samples never clump together and
+// cover the whole pixel. The rows are the largest divisor of count up to
+// its square root, a prime count gives a single row of count columns.
+inline void StratificationGrid(int count, int& columns, int& rows)
+{
+	rows = static_cast<int>(std::sqrt(static_cast<float>(count)));
+	while (rows > 1 && count % rows != 0)
+	{
+		--rows;
+	}
+	rows = std::max(rows, 1);
+	columns = count / rows;
+}
+
+}// namespace raytracing
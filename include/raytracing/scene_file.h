@@ -0,0 +1,187 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "maths/vector3.h"
+#include "raytracing/bvh.h"
+#include "raytracing/camera.h"
+#include "raytracing/light_tree.h"
+#include "raytracing/mapped_file.h"
+#include "raytracing/material.h"
+#include "raytracing/sphere_arrays.h"
+
+namespace raytracing {
+
+// Plane of a scene, its material being an index in the material table
+struct ScenePlane {
+	maths::Vector3f point;
+	maths::Vector3f normal;
+	std::uint32_t material_index = 0;
+};
+
+// Scene as written by hand in the text format, one object per line:
+//   image <width> <height>
+//   bias <bias>
+//   camera <fov in radians> <aspect, 0 for the image one> <x> <y> <z> [<3x3 rotation rows>]
+//   material <reflexion index> <r> <g> <b>
+//   sphere <x> <y> <z> <radius> <material>
+//   plane <point x> <y> <z> <normal x> <y> <z> <material>
+//   light <x> <y> <z> [<intensity> [<falloff radius>]]
+// Lines starting with # are comments. Materials are numbered in their order.
+struct SceneDescription {
+	SphereArrays spheres;
+	std::vector<ScenePlane> planes;
+	std::vector<Material> materials;
+	std::vector<PointLight> lights;
+	Camera camera;
+	int width = 640;
+	int height = 360;
+	double bias = 1e-4;
+};
+
+// Read a scene in the text format, return false on a malformed line, on
+// an image size or a light out of range or on a material index out of the table
+bool ParseScene(std::string_view text, SceneDescription& scene);
+
+// Sections of the binary format, each one starting on a 64 bytes boundary
+enum class SceneSection : std::uint32_t {
+	kSphereCenterX,
+	kSphereCenterY,
+	kSphereCenterZ,
+	kSphereRadius,
+	kSphereMaterial,
+	kPlanes,
+	kMaterials,
+	kLights,
+	kBvhNodes,
+	kBvhIndices,
+	kCount
+};
+
+struct SceneMaterialRecord {
+	float color[3];
+	float reflexion_index;
+};
+
+struct SceneLightRecord {
+	float position[3];
+	float intensity;
+	float falloff_radius;
+};
+
+// Start of a binary scene file. The file is written in the byte order of
+// the machine, the arrays after the header have the layout of the ones of
+// the raytracer so loading copies them without parsing.
+struct SceneFileHeader {
+	static constexpr char kMagic[4] = { 'R', 'T', 'S', 'C' };
+	static constexpr std::uint32_t kVersion = 1;
+	// Largest width and height of the image
+	static constexpr std::uint32_t kMaxImageSize = 16384;
+
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t width;
+	std::uint32_t height;
+	double bias;
+	float camera_position[3];
+	float camera_fov;
+	float camera_aspect;
+	// The columns of the orientation one after the other
+	float camera_orientation[16];
+	std::uint64_t sphere_count;
+	std::uint64_t plane_count;
+	std::uint64_t material_count;
+	std::uint64_t light_count;
+	// Hierarchy built over the spheres, empty if it is built at loading
+	std::uint64_t bvh_node_count;
+	std::uint64_t section_offsets[static_cast<std::size_t>(SceneSection::kCount)];
+};
+
+// Write the scene in the binary format with the hierarchy over its
+// spheres, so loading it needs no build either. The spheres are then
+// written in the order of the leaves, as the raytracer stores them.
+bool WriteSceneFile(const std::string& path, const SceneDescription& scene, bool with_bvh = true);
+
+// Read a scene in the text format and write it in the binary format
+bool ConvertSceneFile(const std::string& text_path, const std::string& binary_path);
+
+// Binary scene mapped in memory. Opening checks the header, that the
+// sections fit in the file and every index stored in them: the material of
+// the spheres and planes and the hierarchy, whose depth must also fit the
+// traversal. The image size must be between 1 and kMaxImageSize and the
+// lights as ParseScene accepts them. A file failing a check is not opened.
+class SceneFile {
+public:
+	bool Open(const std::string& path);
+	void Close();
+	bool is_open() const { return header_ != nullptr; }
+
+	const SceneFileHeader& header() const { return *header_; }
+	int width() const { return static_cast<int>(header_->width); }
+	int height() const { return static_cast<int>(header_->height); }
+	double bias() const { return header_->bias; }
+	Camera camera() const;
+
+	std::span<const float> sphere_center_x() const { return Section<float>(SceneSection::kSphereCenterX); }
+	std::span<const float> sphere_center_y() const { return Section<float>(SceneSection::kSphereCenterY); }
+	std::span<const float> sphere_center_z() const { return Section<float>(SceneSection::kSphereCenterZ); }
+	std::span<const float> sphere_radius() const { return Section<float>(SceneSection::kSphereRadius); }
+	std::span<const std::uint32_t> sphere_material_index() const
+	{
+		return Section<std::uint32_t>(SceneSection::kSphereMaterial);
+	}
+	std::span<const ScenePlane> planes() const { return Section<ScenePlane>(SceneSection::kPlanes); }
+	std::span<const SceneMaterialRecord> materials() const
+	{
+		return Section<SceneMaterialRecord>(SceneSection::kMaterials);
+	}
+	std::span<const SceneLightRecord> lights() const { return Section<SceneLightRecord>(SceneSection::kLights); }
+	std::span<const BvhNode> bvh_nodes() const { return Section<BvhNode>(SceneSection::kBvhNodes); }
+	std::span<const std::uint32_t> bvh_primitive_indices() const
+	{
+		return Section<std::uint32_t>(SceneSection::kBvhIndices);
+	}
+
+	// Number of elements of a section
+	std::size_t SectionCount(SceneSection section) const;
+
+private:
+	template<typename T>
+	std::span<const T> Section(SceneSection section) const
+	{
+		const std::uint64_t offset = header_->section_offsets[static_cast<std::size_t>(section)];
+		return { reinterpret_cast<const T*>(file_.data() + offset), SectionCount(section) };
+	}
+
+	MappedFile file_;
+	const SceneFileHeader* header_ = nullptr;
+};
+
+}// namespace raytracing
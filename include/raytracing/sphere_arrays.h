@@ -0,0 +1,142 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "maths/aabb3.h"
+#include "maths/vector3.h"
+
+namespace raytracing {
+
+// Spheres of a scene stored component by component. The intersection loops
+// only read the geometry arrays, the material of a sphere is an index in
+// the material table of the scene and is only read once the closest hit is known.
+struct SphereArrays {
+	std::vector<float> center_x;
+	std::vector<float> center_y;
+	std::vector<float> center_z;
+	std::vector<float> radius;
+	std::vector<std::uint32_t> material_index;
+
+	std::size_t size() const { return radius.size(); }
+	bool empty() const { return radius.empty(); }
+
+	void clear()
+	{
+		center_x.clear();
+		center_y.clear();
+		center_z.clear();
+		radius.clear();
+		material_index.clear();
+	}
+
+	void reserve(std::size_t count)
+	{
+		center_x.reserve(count);
+		center_y.reserve(count);
+		center_z.reserve(count);
+		radius.reserve(count);
+		material_index.reserve(count);
+	}
+
+	void push_back(const maths::Vector3f& center, float sphere_radius, std::uint32_t material)
+	{
+		center_x.push_back(center.x);
+		center_y.push_back(center.y);
+		center_z.push_back(center.z);
+		radius.push_back(sphere_radius);
+		material_index.push_back(material);
+	}
+
+	// Put the spheres in the given order, order[i] being the index
+	// of the sphere that goes to i
+	void Reorder(std::span<const std::uint32_t> order)
+	{
+		auto reorder = [order](auto& values)
+		{
+			auto reordered = values;
+			for (std::size_t i = 0; i < order.size(); ++i)
+			{
+				reordered[i] = values[order[i]];
+			}
+			values = std::move(reordered);
+		};
+		reorder(center_x);
+		reorder(center_y);
+		reorder(center_z);
+		reorder(radius);
+		reorder(material_index);
+	}
+
+	maths::Vector3f center(std::size_t index) const
+	{
+		return { center_x[index], center_y[index], center_z[index] };
+	}
+
+	maths::AABB3 bounds(std::size_t index) const
+	{
+		const maths::Vector3f extent(radius[index], radius[index], radius[index]);
+		return { center(index) - extent, center(index) + extent };
+	}
+};
+
+// Return true if the ray hits the sphere closer than distance and set distance
+// to the hit. Same arithmetic as maths::Ray3::IntersectSphere.
+inline bool IntersectSphere(
+	const SphereArrays& spheres,
+	std::size_t index,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance)
+{
+	const float v_x = spheres.center_x[index] - origin.x;
+	const float v_y = spheres.center_y[index] - origin.y;
+	const float v_z = spheres.center_z[index] - origin.z;
+	// Distance to closest point to sphere center
+	const float d = v_x * direction.x + v_y * direction.y + v_z * direction.z;
+	if (d < 0.0f)
+	{
+		return false;
+	}
+	const float squared_distance = (v_x * v_x + v_y * v_y + v_z * v_z) - d * d;
+	const float radius2 = spheres.radius[index] * spheres.radius[index];
+	if (squared_distance > radius2)
+	{
+		return false;
+	}
+	const float q = std::sqrt(radius2 - squared_distance);
+	const float t = d - q >= 0.0f ? d - q : d + q;
+	if (t >= distance)
+	{
+		return false;
+	}
+	distance = t;
+	return true;
+}
+
+}// namespace raytracing
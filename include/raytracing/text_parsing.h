@@ -0,0 +1,77 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <charconv>
+#include <string_view>
+
+namespace raytracing {
+
+// Helpers shared by the text formats read in place from a mapped file,
+// a line being split in tokens separated by spaces
+inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Move begin past the spaces, then return the characters
+// up to the next space
+inline std::string_view NextToken(const char*& begin, const char* end)
+{
+	while (begin != end && IsSpace(*begin))
+	{
+		++begin;
+	}
+	const char* token_begin = begin;
+	while (begin != end && !IsSpace(*begin))
+	{
+		++begin;
+	}
+	return { token_begin, static_cast<std::size_t>(begin - token_begin) };
+}
+
+// Return the end of the line starting at begin
+inline const char* LineEnd(const char* begin, const char* end)
+{
+	while (begin != end && *begin != '\n')
+	{
+		++begin;
+	}
+	return begin;
+}
+
+// Read a number taking the whole token
+template<typename T>
+bool ParseNumber(std::string_view token, T& value)
+{
+	const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+	return error == std::errc() && end == token.data() + token.size();
+}
+
+inline bool ParseFloat(std::string_view token, float& value)
+{
+	return ParseNumber(token, value);
+}
+
+}// namespace raytracing
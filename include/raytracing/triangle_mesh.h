@@ -0,0 +1,147 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "maths/aabb3.h"
+#include "maths/vector3.h"
+
+namespace raytracing {
+
+// Triangles sharing their vertices, each triangle is three
+// consecutive indices in the vertex buffer
+struct TriangleMesh {
+	std::vector<maths::Vector3f> vertices;
+	std::vector<std::uint32_t> indices;
+
+	std::size_t triangle_count() const { return indices.size() / 3; }
+	bool empty() const { return indices.empty(); }
+
+	void clear()
+	{
+		vertices.clear();
+		indices.clear();
+	}
+
+	const maths::Vector3f& vertex(std::size_t triangle, int corner) const
+	{
+		return vertices[indices[3 * triangle + corner]];
+	}
+
+	maths::AABB3 bounds(std::size_t triangle) const
+	{
+		const maths::Vector3f& v0 = vertex(triangle, 0);
+		const maths::Vector3f& v1 = vertex(triangle, 1);
+		const maths::Vector3f& v2 = vertex(triangle, 2);
+		return {
+			maths::Vector3f(std::min({ v0.x, v1.x, v2.x }), std::min({ v0.y, v1.y, v2.y }), std::min({ v0.z, v1.z, v2.z })),
+			maths::Vector3f(std::max({ v0.x, v1.x, v2.x }), std::max({ v0.y, v1.y, v2.y }), std::max({ v0.z, v1.z, v2.z })) };
+	}
+
+	// Normal of the plane of a triangle, facing the side where its
+	// vertices are seen counterclockwise
+	maths::Vector3f normal(std::size_t triangle) const
+	{
+		const maths::Vector3f& v0 = vertex(triangle, 0);
+		return maths::Vector3f::Cross(vertex(triangle, 1) - v0, vertex(triangle, 2) - v0).Normalized();
+	}
+
+	// Append the triangles of another mesh, return the index of its first triangle
+	std::size_t Append(const TriangleMesh& mesh);
+
+	// Bytes used by the vertex and index buffers
+	std::size_t memory_size() const
+	{
+		return vertices.capacity() * sizeof(maths::Vector3f) + indices.capacity() * sizeof(std::uint32_t);
+	}
+};
+
+// Moller-Trumbore intersection, update distance and return true
+// only if the triangle is hit in front of the origin and closer than distance
+inline bool IntersectTriangle(
+	const maths::Vector3f& v0,
+	const maths::Vector3f& v1,
+	const maths::Vector3f& v2,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance)
+{
+	const maths::Vector3f edge1 = v1 - v0;
+	const maths::Vector3f edge2 = v2 - v0;
+	const maths::Vector3f p = maths::Vector3f::Cross(direction, edge2);
+	const float determinant = maths::Vector3f::Dot(edge1, p);
+	// The ray is parallel to the triangle
+	if (std::abs(determinant) < 1e-12f)
+	{
+		return false;
+	}
+	const float inv_determinant = 1.0f / determinant;
+
+	const maths::Vector3f to_origin = origin - v0;
+	const float u = maths::Vector3f::Dot(to_origin, p) * inv_determinant;
+	if (u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+	const maths::Vector3f q = maths::Vector3f::Cross(to_origin, edge1);
+	const float v = maths::Vector3f::Dot(direction, q) * inv_determinant;
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+	const float hit_distance = maths::Vector3f::Dot(edge2, q) * inv_determinant;
+	if (hit_distance <= 0.0f || hit_distance >= distance)
+	{
+		return false;
+	}
+	distance = hit_distance;
+	return true;
+}
+
+inline bool IntersectTriangle(
+	const TriangleMesh& mesh,
+	std::size_t triangle,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance)
+{
+	return IntersectTriangle(mesh.vertex(triangle, 0), mesh.vertex(triangle, 1), mesh.vertex(triangle, 2),
+		origin, direction, distance);
+}
+
+// Read the vertices and faces of a Wavefront .obj text, faces with more
+// than three vertices are split in triangles. The other statements are
+// ignored. Return false if a vertex or a face can not be read.
+bool ParseObj(std::string_view text, TriangleMesh& mesh);
+
+// Map the .obj file at path and parse it into mesh
+bool LoadObj(const std::string& path, TriangleMesh& mesh);
+
+}// namespace raytracing
@@ -0,0 +1,128 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "maths/aabb3.h"
+#include "maths/ray3.h"
+#include "raytracing/ray_packet.h"
+
+namespace raytracing {
+
+constexpr int kWideBoxSize = 4;
+
+// Bounds of the children of a wide node, stored component by component
+// so that a single SSE register holds the same bound of every box
+struct alignas(16) WideBox {
+	float min_x[kWideBoxSize];
+	float min_y[kWideBoxSize];
+	float min_z[kWideBoxSize];
+	float max_x[kWideBoxSize];
+	float max_y[kWideBoxSize];
+	float max_z[kWideBoxSize];
+
+	void Set(int lane, const maths::AABB3& aabb)
+	{
+		min_x[lane] = aabb.bottom_left().x;
+		min_y[lane] = aabb.bottom_left().y;
+		min_z[lane] = aabb.bottom_left().z;
+		max_x[lane] = aabb.top_right().x;
+		max_y[lane] = aabb.top_right().y;
+		max_z[lane] = aabb.top_right().z;
+	}
+
+	// Make a lane that no ray can hit, for nodes with fewer children
+	void SetEmpty(int lane)
+	{
+		const float inf = std::numeric_limits<float>::infinity();
+		min_x[lane] = inf;
+		min_y[lane] = inf;
+		min_z[lane] = inf;
+		max_x[lane] = -inf;
+		max_y[lane] = -inf;
+		max_z[lane] = -inf;
+	}
+};
+
+// Slab test of one ray against the four boxes at once. Return the mask of the
+// boxes entered before max_distance and store their entry distances in tmin.
+inline int IntersectWideBox(
+	const maths::SlabRay3& ray,
+	const WideBox& boxes,
+	float max_distance,
+	float tmin[kWideBoxSize])
+{
+	// The signs of the ray pick the near and far planes of every box
+	const float* near_x = ray.sign(0) ? boxes.max_x : boxes.min_x;
+	const float* far_x = ray.sign(0) ? boxes.min_x : boxes.max_x;
+	const float* near_y = ray.sign(1) ? boxes.max_y : boxes.min_y;
+	const float* far_y = ray.sign(1) ? boxes.min_y : boxes.max_y;
+	const float* near_z = ray.sign(2) ? boxes.max_z : boxes.min_z;
+	const float* far_z = ray.sign(2) ? boxes.min_z : boxes.max_z;
+	const maths::Vector3f& origin = ray.origin();
+	const maths::Vector3f& inv_direction = ray.inv_direction();
+#ifdef RAYTRACING_SSE
+	const __m128 origin_x = _mm_set1_ps(origin.x);
+	const __m128 origin_y = _mm_set1_ps(origin.y);
+	const __m128 origin_z = _mm_set1_ps(origin.z);
+	const __m128 inv_x = _mm_set1_ps(inv_direction.x);
+	const __m128 inv_y = _mm_set1_ps(inv_direction.y);
+	const __m128 inv_z = _mm_set1_ps(inv_direction.z);
+
+	__m128 entry = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(near_x), origin_x), inv_x);
+	__m128 exit = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(far_x), origin_x), inv_x);
+	entry = _mm_max_ps(entry, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(near_y), origin_y), inv_y));
+	exit = _mm_min_ps(exit, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(far_y), origin_y), inv_y));
+	entry = _mm_max_ps(entry, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(near_z), origin_z), inv_z));
+	exit = _mm_min_ps(exit, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(far_z), origin_z), inv_z));
+
+	const __m128 hit_mask = _mm_and_ps(
+		_mm_and_ps(_mm_cmpge_ps(exit, entry), _mm_cmplt_ps(entry, _mm_set1_ps(max_distance))),
+		_mm_cmpgt_ps(exit, _mm_setzero_ps()));
+	_mm_storeu_ps(tmin, entry);
+	return _mm_movemask_ps(hit_mask);
+#else
+	int mask = 0;
+	for (int lane = 0; lane < kWideBoxSize; ++lane)
+	{
+		float entry = (near_x[lane] - origin.x) * inv_direction.x;
+		float exit = (far_x[lane] - origin.x) * inv_direction.x;
+		entry = std::max(entry, (near_y[lane] - origin.y) * inv_direction.y);
+		exit = std::min(exit, (far_y[lane] - origin.y) * inv_direction.y);
+		entry = std::max(entry, (near_z[lane] - origin.z) * inv_direction.z);
+		exit = std::min(exit, (far_z[lane] - origin.z) * inv_direction.z);
+		tmin[lane] = entry;
+		if (exit >= entry && entry < max_distance && exit > 0.0f)
+		{
+			mask |= 1 << lane;
+		}
+	}
+	return mask;
+#endif
+}
+
+}// namespace raytracing
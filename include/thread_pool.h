@@ -0,0 +1,82 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace threading {
+
+// Pool of threads where each thread owns a queue of tasks and steals
+// from the other queues once its own is empty, so uneven tasks keep
+// every thread busy until the end of the batch.
+class ThreadPool {
+public:
+	// The calling thread takes part in the work, so thread_count - 1
+	// threads are created. A thread count of 0 uses every hardware thread.
+	explicit ThreadPool(std::size_t thread_count = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	std::size_t thread_count() const { return queues_.size(); }
+
+	// Call task(index) for every index in [0, count) and wait until all are done.
+	// The task must be safe to call concurrently with different indices.
+	void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& task);
+
+private:
+	struct TaskQueue {
+		std::mutex mutex;
+		std::deque<std::size_t> tasks;
+	};
+
+	void WorkerLoop(std::size_t queue_index);
+	// Run tasks from the given queue, then from the other ones, until all are empty
+	void RunTasks(std::size_t queue_index);
+	std::optional<std::size_t> PopTask(std::size_t queue_index);
+	std::optional<std::size_t> StealTask(std::size_t queue_index);
+
+	std::vector<std::unique_ptr<TaskQueue>> queues_;
+	std::vector<std::thread> workers_;
+
+	std::mutex mutex_;
+	std::condition_variable work_condition_;
+	std::condition_variable done_condition_;
+	const std::function<void(std::size_t)>* task_ = nullptr;
+	std::size_t generation_ = 0;
+	std::atomic<std::size_t> remaining_tasks_{ 0 };
+	bool stop_ = false;
+};
+
+}// namespace threading
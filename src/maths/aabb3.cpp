@@ -24,6 +24,18 @@ SOFTWARE.
 
 #include "maths/aabb3.h"
 
+#include <algorithm>
+
 namespace maths {
 
+AABB3 Merge(const AABB3& a, const AABB3& b) {
+	const Vector3f a_min = a.bottom_left();
+	const Vector3f a_max = a.top_right();
+	const Vector3f b_min = b.bottom_left();
+	const Vector3f b_max = b.top_right();
+	return {
+		Vector3f(std::min(a_min.x, b_min.x), std::min(a_min.y, b_min.y), std::min(a_min.z, b_min.z)),
+		Vector3f(std::max(a_max.x, b_max.x), std::max(a_max.y, b_max.y), std::max(a_max.z, b_max.z)) };
+}
+
 }  // namespace maths
@@ -65,10 +65,6 @@ bool Frustum::contains(const Sphere& sphere)
 		{
 			return false;
 		}
-		else if (distance < sphere.radius())
-		{
-			return true;
-		}
 	}
 	return true;
 }
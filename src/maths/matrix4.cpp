@@ -267,10 +267,10 @@ Matrix4f Matrix4f::scalingMatrix(Vector3f axisValues) {
 }
 Matrix4f Matrix4f::translationMatrix(Vector3f axisValues) {
 	
-	return Matrix4f(Vector4f(1, 0, 0, axisValues.x),
-					Vector4f(0, 1, 0, axisValues.y),
-					Vector4f(0, 0, 1, axisValues.z),
-					Vector4f(0, 0, 0, 1));
+	return Matrix4f(Vector4f(1, 0, 0, 0),
+					Vector4f(0, 1, 0, 0),
+					Vector4f(0, 0, 1, 0),
+					Vector4f(axisValues.x, axisValues.y, axisValues.z, 1));
 }
 	
 }//namespace maths
\ No newline at end of file
@@ -129,11 +129,11 @@ bool Ray3::IntersectAABB3(const AABB3& aabb) {
 
 bool Ray3::IntersectPlane(const Plane& plane, Vector3f& hitPosition) {
     const float s = direction_.Dot(plane.normal());
-    if (s > 0) {
+    if (s >= 0) {
         return false;
     }
-    const float distance = (plane.Distance(plane.point()) - origin_.Dot(
-                          plane.normal())) / s;
+    // distance along the ray to reach the plane from the signed distance of the origin
+    const float distance = -plane.Distance(origin_) / s;
     if (distance < 0) {
         return false;
     }
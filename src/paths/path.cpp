@@ -23,72 +23,131 @@ SOFTWARE.
 */
 
 #include "paths/path.h"
-#include "paths/inverted_priority_queue.h"
+
+#include <algorithm>
+#include <cassert>
 
 namespace path {
 
-std::vector<NodeIndex> Map::FindPath(NodeIndex start_node, NodeIndex end_node) {
-	
-	// This queue contains next nodes where we will check these neighbors.
-	PriorityQueue<NodeIndex, float> frontier;
-	frontier.put(start_node, 0.0f);
+void Map::AddNode(maths::Vector2f position, std::span<const NodeIndex> neighbors) {
+	const NodeIndex node = static_cast<NodeIndex>(node_count());
+	positions_x_.push_back(position.x);
+	positions_y_.push_back(position.y);
+	for (const NodeIndex next : neighbors) {
+		const std::uint32_t edge = static_cast<std::uint32_t>(neighbors_.size());
+		neighbors_.push_back(next);
+		if (next <= node) {
+			edge_costs_.push_back(Distance(node, next));
+		}
+		else {
+			// The distance waits for the position of the neighbor.
+			edge_costs_.push_back(kDistanceCost);
+			pending_edges_.push({next, node, edge});
+		}
+	}
+	offsets_.push_back(static_cast<std::uint32_t>(neighbors_.size()));
+	ResolvePendingEdges();
+}
 
-	came_from_[start_node] = start_node;
-	cost_so_far_[start_node] = 0.0f;
-	NodeIndex current;
+void Map::AddNode(maths::Vector2f position, std::span<const NodeIndex> neighbors,
+	std::span<const float> edge_costs) {
+	assert(edge_costs.size() == neighbors.size());
+	positions_x_.push_back(position.x);
+	positions_y_.push_back(position.y);
+	neighbors_.insert(neighbors_.end(), neighbors.begin(), neighbors.end());
+	edge_costs_.insert(edge_costs_.end(), edge_costs.begin(), edge_costs.end());
+	offsets_.push_back(static_cast<std::uint32_t>(neighbors_.size()));
+	ResolvePendingEdges();
+}
 
-	while (!frontier.empty()) {
-		// Get the lowest priority node.
-		current = frontier.get();
+void Map::Reserve(std::size_t node_count, std::size_t edge_count) {
+	offsets_.reserve(node_count + 1);
+	positions_x_.reserve(node_count);
+	positions_y_.reserve(node_count);
+	neighbors_.reserve(edge_count);
+	edge_costs_.reserve(edge_count);
+}
 
-		if (current == end_node) {
-			break;
-		}
+float Map::Distance(NodeIndex node, NodeIndex other) const {
+	return maths::Vector2f {
+		positions_x_[node] - positions_x_[other]
+		, positions_y_[node] - positions_y_[other]}.Magnitude();
+}
 
-		for (NodeIndex next : graph_[current].neighbors()) {
-			// The cost to get to the current node added to the distance to the neighbor.
-			const float new_cost = cost_so_far_[current]
-				+ maths::Vector2f {
-				    graph_[current].position().x
-					- graph_[next].position().x
-					, graph_[current].position().y
-					- graph_[next].position().y}.Magnitude(); 
-			/* Check if the node has been checked and if cost to go to the next
-			node from current is less than the lowest cost saved to go to the
-			next node.*/
-			if (cost_so_far_.find(next) == cost_so_far_.end() 
-				|| new_cost < cost_so_far_[next]) {
-				// Put the new lowest cost to go to next node.
-				cost_so_far_[next] = new_cost; 
-				// Calculate the heuristic.
-				const float priority = new_cost
-					+ maths::Vector2f {
-					    graph_[next].position().x
-						- graph_[end_node].position().x
-						, graph_[next].position().y
-						- graph_[end_node].position().y}.Magnitude();
-				// Add to nodes where we will check these neighbors.
-				frontier.put(next, priority); 
-				/* Save the current node with the lowest cost to go to the next
-				node. */
-				came_from_[next] = current; 
-			}
-		}
+void Map::ResolvePendingEdges() {
+	// The nodes are added in order, so the edges waiting for the last node
+	// are the first ones of the queue.
+	const NodeIndex last_node = static_cast<NodeIndex>(node_count() - 1);
+	while (!pending_edges_.empty() && pending_edges_.top().neighbor == last_node) {
+		const PendingEdge& pending = pending_edges_.top();
+		edge_costs_[pending.edge] = Distance(pending.node, last_node);
+		pending_edges_.pop();
+	}
+}
+
+void SearchContext::NextGeneration(std::size_t node_count) {
+	// New nodes start as never visited.
+	if (visited_generation.size() < node_count) {
+		came_from.resize(node_count);
+		cost_so_far.resize(node_count);
+		visited_generation.resize(node_count, 0);
+		frontier.reserve(node_count);
+	}
+	++generation;
+	// After a wrap around, old generations could be taken for the new one.
+	if (generation == 0) {
+		std::fill(visited_generation.begin(), visited_generation.end(), 0);
+		generation = 1;
 	}
-	/* Return an empty vector of NodeIndex if there is no path to go to the end
-	node.*/
-	if (current != end_node) {
-		std::vector<NodeIndex> no_path_vector;
-		return no_path_vector;
+}
+
+std::unique_ptr<SearchContext> SearchContextPool::Acquire() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (contexts_.empty()) {
+		return std::make_unique<SearchContext>();
 	}
+	std::unique_ptr<SearchContext> context = std::move(contexts_.back());
+	contexts_.pop_back();
+	return context;
+}
+
+void SearchContextPool::Release(std::unique_ptr<SearchContext> context) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	contexts_.push_back(std::move(context));
+}
+
+void SearchContextPool::Clear() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	contexts_.clear();
+}
+
+void Map::BeginQuery(NodeIndex start_node, SearchContext& context) const {
+	context.NextGeneration(node_count());
+
+	// This queue contains next nodes where we will check these neighbors.
+	context.frontier.clear();
+	context.frontier.put(start_node, 0.0f);
+
+	context.came_from[start_node] = start_node;
+	context.cost_so_far[start_node] = 0.0f;
+	context.visited_generation[start_node] = context.generation;
+}
+
+std::vector<NodeIndex> Map::BuildPath(NodeIndex start_node, NodeIndex end_node, SearchContext& context) {
 	// Add NodeIndex of nodes with the lowest cost to go to each node.
-	path_.push_back(current);
+	NodeIndex current = end_node;
+	context.path.clear();
+	context.path.push_back(current);
 	while (current != start_node) {
-		current = came_from_[current];
-		path_.push_back(current);
+		current = context.came_from[current];
+		context.path.push_back(current);
 	}
 	// Reverse path to start with the start node.
-	return {path_.rbegin(), path_.rend()};
+	return {context.path.rbegin(), context.path.rend()};
+}
+
+std::vector<NodeIndex> Map::FindPath(NodeIndex start_node, NodeIndex end_node) const {
+	return FindPath(start_node, end_node, EuclideanHeuristic());
 }
 
 }  // namespace path
@@ -0,0 +1,326 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#include "raytracing/bvh.h"
+
+namespace raytracing {
+
+namespace {
+
+maths::AABB3 EmptyBounds()
+{
+	const float inf = std::numeric_limits<float>::infinity();
+	return { maths::Vector3f(inf, inf, inf), maths::Vector3f(-inf, -inf, -inf) };
+}
+
+bool IsEmpty(const maths::AABB3& aabb)
+{
+	return aabb.bottom_left().x > aabb.top_right().x;
+}
+
+}// namespace
+
+void Bvh::Build(const std::vector<maths::AABB3>& bounds)
+{
+	Clear();
+	if (bounds.empty())
+	{
+		return;
+	}
+	const auto primitive_count = static_cast<std::uint32_t>(bounds.size());
+	primitive_indices_.resize(primitive_count);
+	std::iota(primitive_indices_.begin(), primitive_indices_.end(), 0u);
+
+	std::vector<maths::Vector3f> centroids(primitive_count);
+	for (std::uint32_t i = 0; i < primitive_count; ++i)
+	{
+		centroids[i] = bounds[i].center();
+	}
+
+	// A binary tree with n leaves never has more than 2n - 1 nodes
+	nodes_.reserve(2 * static_cast<std::size_t>(primitive_count) - 1);
+	BvhNode& root = nodes_.emplace_back();
+	root.left_first = 0;
+	root.primitive_count = primitive_count;
+	UpdateNodeBounds(0, bounds);
+	Subdivide(0, bounds, centroids, 0);
+}
+
+std::vector<std::uint32_t> Bvh::RenumberPrimitives(std::size_t count)
+{
+	std::vector<std::uint32_t> previous_indices;
+	previous_indices.reserve(count);
+	for (std::uint32_t& index : primitive_indices_)
+	{
+		if (index < count)
+		{
+			previous_indices.push_back(index);
+			index = static_cast<std::uint32_t>(previous_indices.size() - 1);
+		}
+	}
+	return previous_indices;
+}
+
+void Bvh::Assign(std::span<const BvhNode> nodes, std::span<const std::uint32_t> primitive_indices)
+{
+	nodes_.assign(nodes.begin(), nodes.end());
+	primitive_indices_.assign(primitive_indices.begin(), primitive_indices.end());
+}
+
+bool Bvh::IsValid(
+	std::span<const BvhNode> nodes,
+	std::span<const std::uint32_t> primitive_indices,
+	std::size_t primitive_count)
+{
+	for (const std::uint32_t primitive_index : primitive_indices)
+	{
+		if (primitive_index >= primitive_count)
+		{
+			return false;
+		}
+	}
+	if (nodes.empty())
+	{
+		return primitive_indices.empty();
+	}
+
+	// Nodes waiting to be checked, with their depth. Each node must be
+	// reached once: children shared by several parents would let a small
+	// file describe a tree of exponential size
+	std::pair<std::uint32_t, int> stack[kMaxDepth];
+	int stack_size = 0;
+	stack[stack_size++] = { 0, 0 };
+	std::vector<bool> reached(nodes.size(), false);
+	std::size_t reached_count = 0;
+	while (stack_size > 0)
+	{
+		const auto [node_index, depth] = stack[--stack_size];
+		if (reached[node_index])
+		{
+			return false;
+		}
+		reached[node_index] = true;
+		++reached_count;
+		const BvhNode& node = nodes[node_index];
+		if (node.IsLeaf())
+		{
+			if (node.left_first > primitive_indices.size()
+				|| node.primitive_count > primitive_indices.size() - node.left_first)
+			{
+				return false;
+			}
+			continue;
+		}
+		// The children after the parent also rule out cycles
+		if (node.left_first <= node_index
+			|| node.left_first >= nodes.size() - 1
+			|| depth + 1 >= kMaxDepth)
+		{
+			return false;
+		}
+		stack[stack_size++] = { node.left_first, depth + 1 };
+		stack[stack_size++] = { node.left_first + 1, depth + 1 };
+	}
+	return reached_count == nodes.size();
+}
+
+void Bvh::Refit(const std::vector<maths::AABB3>& bounds)
+{
+	assert(bounds.size() == primitive_indices_.size());
+	// Children are always stored after their parent, so a reverse sweep
+	// updates them first
+	for (std::size_t i = nodes_.size(); i-- > 0;)
+	{
+		BvhNode& node = nodes_[i];
+		if (node.IsLeaf())
+		{
+			UpdateNodeBounds(static_cast<std::uint32_t>(i), bounds);
+			continue;
+		}
+		const BvhNode& left = nodes_[node.left_first];
+		const BvhNode& right = nodes_[node.left_first + 1];
+		const maths::AABB3 node_bounds = maths::Merge(
+			maths::AABB3(left.bounds_min, left.bounds_max),
+			maths::AABB3(right.bounds_min, right.bounds_max));
+		node.bounds_min = node_bounds.bottom_left();
+		node.bounds_max = node_bounds.top_right();
+	}
+}
+
+void Bvh::UpdateNodeBounds(std::uint32_t node_index, const std::vector<maths::AABB3>& bounds)
+{
+	BvhNode& node = nodes_[node_index];
+	maths::AABB3 node_bounds = EmptyBounds();
+	for (std::uint32_t i = 0; i < node.primitive_count; ++i)
+	{
+		node_bounds = maths::Merge(node_bounds, bounds[primitive_indices_[node.left_first + i]]);
+	}
+	node.bounds_min = node_bounds.bottom_left();
+	node.bounds_max = node_bounds.top_right();
+}
+
+void Bvh::Subdivide(
+	std::uint32_t node_index,
+	const std::vector<maths::AABB3>& bounds,
+	const std::vector<maths::Vector3f>& centroids,
+	int depth)
+{
+	const std::uint32_t first = nodes_[node_index].left_first;
+	const std::uint32_t count = nodes_[node_index].primitive_count;
+	if (count <= 1 || depth >= kMaxDepth - 1)
+	{
+		return;
+	}
+
+	// Bin the centroids instead of the bounds so every primitive falls in one bin
+	maths::Vector3f centroid_min = centroids[primitive_indices_[first]];
+	maths::Vector3f centroid_max = centroid_min;
+	for (std::uint32_t i = 1; i < count; ++i)
+	{
+		const maths::Vector3f& centroid = centroids[primitive_indices_[first + i]];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			centroid_min[axis] = std::min(centroid_min[axis], centroid[axis]);
+			centroid_max[axis] = std::max(centroid_max[axis], centroid[axis]);
+		}
+	}
+
+	float best_cost = std::numeric_limits<float>::max();
+	int best_axis = -1;
+	int best_split = 0;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float extent = centroid_max[axis] - centroid_min[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+		const float scale = kBinCount / extent;
+
+		maths::AABB3 bin_bounds[kBinCount];
+		std::uint32_t bin_counts[kBinCount] = {};
+		std::fill(std::begin(bin_bounds), std::end(bin_bounds), EmptyBounds());
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			const std::uint32_t primitive = primitive_indices_[first + i];
+			const int bin = std::min(kBinCount - 1,
+				static_cast<int>((centroids[primitive][axis] - centroid_min[axis]) * scale));
+			bin_counts[bin]++;
+			bin_bounds[bin] = maths::Merge(bin_bounds[bin], bounds[primitive]);
+		}
+
+		// Sweep from both sides to get the cost of each of the kBinCount - 1 planes
+		float left_areas[kBinCount - 1];
+		float right_areas[kBinCount - 1];
+		std::uint32_t left_counts[kBinCount - 1];
+		std::uint32_t right_counts[kBinCount - 1];
+		maths::AABB3 left_bounds = EmptyBounds();
+		maths::AABB3 right_bounds = EmptyBounds();
+		std::uint32_t left_count = 0;
+		std::uint32_t right_count = 0;
+		for (int i = 0; i < kBinCount - 1; ++i)
+		{
+			left_count += bin_counts[i];
+			left_counts[i] = left_count;
+			if (bin_counts[i] != 0)
+			{
+				left_bounds = maths::Merge(left_bounds, bin_bounds[i]);
+			}
+			left_areas[i] = IsEmpty(left_bounds) ? 0.0f : left_bounds.SurfaceArea();
+
+			right_count += bin_counts[kBinCount - 1 - i];
+			right_counts[kBinCount - 2 - i] = right_count;
+			if (bin_counts[kBinCount - 1 - i] != 0)
+			{
+				right_bounds = maths::Merge(right_bounds, bin_bounds[kBinCount - 1 - i]);
+			}
+			right_areas[kBinCount - 2 - i] = IsEmpty(right_bounds) ? 0.0f : right_bounds.SurfaceArea();
+		}
+		for (int i = 0; i < kBinCount - 1; ++i)
+		{
+			if (left_counts[i] == 0 || right_counts[i] == 0)
+			{
+				continue;
+			}
+			const float cost = left_counts[i] * left_areas[i] + right_counts[i] * right_areas[i];
+			if (cost < best_cost)
+			{
+				best_cost = cost;
+				best_axis = axis;
+				best_split = i;
+			}
+		}
+	}
+
+	// All the centroids are at the same position, nothing to split
+	if (best_axis < 0)
+	{
+		return;
+	}
+	const BvhNode& node = nodes_[node_index];
+	const maths::AABB3 node_bounds(node.bounds_min, node.bounds_max);
+	const float leaf_cost = count * node_bounds.SurfaceArea();
+	if (best_cost >= leaf_cost && count <= kMaxLeafSize)
+	{
+		return;
+	}
+
+	const float extent = centroid_max[best_axis] - centroid_min[best_axis];
+	const float scale = kBinCount / extent;
+	const auto middle = std::partition(
+		primitive_indices_.begin() + first,
+		primitive_indices_.begin() + first + count,
+		[&](std::uint32_t primitive)
+		{
+			const int bin = std::min(kBinCount - 1,
+				static_cast<int>((centroids[primitive][best_axis] - centroid_min[best_axis]) * scale));
+			return bin <= best_split;
+		});
+	const auto left_count = static_cast<std::uint32_t>(middle - (primitive_indices_.begin() + first));
+	if (left_count == 0 || left_count == count)
+	{
+		return;
+	}
+
+	const auto left_index = static_cast<std::uint32_t>(nodes_.size());
+	nodes_.emplace_back();
+	nodes_.emplace_back();
+	nodes_[left_index].left_first = first;
+	nodes_[left_index].primitive_count = left_count;
+	nodes_[left_index + 1].left_first = first + left_count;
+	nodes_[left_index + 1].primitive_count = count - left_count;
+	nodes_[node_index].left_first = left_index;
+	nodes_[node_index].primitive_count = 0;
+
+	UpdateNodeBounds(left_index, bounds);
+	UpdateNodeBounds(left_index + 1, bounds);
+	Subdivide(left_index, bounds, centroids, depth + 1);
+	Subdivide(left_index + 1, bounds, centroids, depth + 1);
+}
+
+}// namespace raytracing
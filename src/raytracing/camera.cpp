@@ -0,0 +1,74 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "raytracing/camera.h"
+
+#include <array>
+
+#include "raytracing/instance.h"
+
+namespace raytracing {
+
+Camera::Camera(
+	const maths::Vector3f& position,
+	const maths::Matrix4f& orientation,
+	maths::radian_t fov,
+	float aspect)
+	: position_(position), orientation_(orientation), fov_(fov), aspect_(aspect)
+{
+}
+
+void Camera::Prepare(int width, int height)
+{
+	right_ = TransformDirection(orientation_, maths::Vector3f(1.0f, 0.0f, 0.0f));
+	up_ = TransformDirection(orientation_, maths::Vector3f(0.0f, 1.0f, 0.0f));
+	forward_ = TransformDirection(orientation_, maths::Vector3f(0.0f, 0.0f, -1.0f));
+
+	const float aspect = aspect_ > 0.0f ?
+		aspect_ : static_cast<float>(width) / static_cast<float>(height);
+	half_height_ = maths::tan(fov_ / 2.0f);
+	half_width_ = half_height_ * aspect;
+	top_left_ = forward_ - right_ * half_width_ + up_ * half_height_;
+	pixel_right_ = right_ * (2.0f * half_width_ / static_cast<float>(width));
+	pixel_down_ = up_ * (-2.0f * half_height_ / static_cast<float>(height));
+}
+
+maths::Frustum Camera::frustum(float near_distance, float far_distance) const
+{
+	// The normals of the sides face the inside, each side holding
+	// the position and one edge of the image plane
+	const maths::Vector3f left_edge = forward_ - right_ * half_width_;
+	const maths::Vector3f right_edge = forward_ + right_ * half_width_;
+	const maths::Vector3f top_edge = forward_ + up_ * half_height_;
+	const maths::Vector3f bottom_edge = forward_ - up_ * half_height_;
+	return maths::Frustum(std::array<maths::Plane, 6>{
+		maths::Plane(position_ + forward_ * near_distance, forward_),
+		maths::Plane(position_ + forward_ * far_distance, forward_ * -1.0f),
+		maths::Plane(position_, maths::Vector3f::Cross(left_edge, up_).Normalized()),
+		maths::Plane(position_, maths::Vector3f::Cross(up_, right_edge).Normalized()),
+		maths::Plane(position_, maths::Vector3f::Cross(top_edge, right_).Normalized()),
+		maths::Plane(position_, maths::Vector3f::Cross(right_, bottom_edge).Normalized()) });
+}
+
+}// namespace raytracing
@@ -0,0 +1,117 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <fstream>
+
+#include "raytracing/image_writer.h"
+
+namespace raytracing {
+
+void ConvertToRgb8(std::span<const maths::Vector3f> colors, std::vector<std::uint8_t>& rgb)
+{
+	const std::size_t component_count = colors.size() * 3;
+	rgb.resize(component_count);
+	if (component_count == 0)
+	{
+		return;
+	}
+	static_assert(sizeof(maths::Vector3f) == 3 * sizeof(float), "Colors must be packed floats");
+	const float* components = colors.front().coord;
+	std::uint8_t* output = rgb.data();
+	for (std::size_t i = 0; i < component_count; ++i)
+	{
+		output[i] = static_cast<std::uint8_t>(std::min(std::max(components[i], 0.0f), 255.0f));
+	}
+}
+
+bool WritePpm(const std::string& path, int width, int height, std::span<const std::uint8_t> rgb)
+{
+	std::ofstream ofs(path, std::ios::out | std::ios::binary);
+	if (!ofs)
+	{
+		return false;
+	}
+	const std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+	ofs.write(header.data(), static_cast<std::streamsize>(header.size()));
+	ofs.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+	return static_cast<bool>(ofs);
+}
+
+AsyncImageWriter::AsyncImageWriter() : thread_(&AsyncImageWriter::WriterLoop, this) {}
+
+AsyncImageWriter::~AsyncImageWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	job_condition_.notify_one();
+	thread_.join();
+}
+
+void AsyncImageWriter::Write(std::string path, int width, int height, std::vector<std::uint8_t>&& rgb)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push_back({ std::move(path), width, height, std::move(rgb) });
+	}
+	job_condition_.notify_one();
+}
+
+bool AsyncImageWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_condition_.wait(lock, [this]() { return jobs_.empty() && !writing_; });
+	const bool succeeded = !failed_;
+	failed_ = false;
+	return succeeded;
+}
+
+void AsyncImageWriter::WriterLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true)
+	{
+		job_condition_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+		if (jobs_.empty())
+		{
+			// Only reached when stopping with nothing left to write
+			return;
+		}
+		Job job = std::move(jobs_.front());
+		jobs_.pop_front();
+		writing_ = true;
+
+		lock.unlock();
+		const bool written = WritePpm(job.path, job.width, job.height, job.rgb);
+		lock.lock();
+
+		writing_ = false;
+		failed_ = failed_ || !written;
+		done_condition_.notify_all();
+	}
+}
+
+}// namespace raytracing
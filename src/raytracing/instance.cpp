@@ -0,0 +1,145 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+
+#include "raytracing/instance.h"
+
+namespace raytracing {
+
+maths::Matrix4f AffineInverse(const maths::Matrix4f& transform)
+{
+	// Invert the 3x3 linear part with its cofactors, a b c being its
+	// first row, read across the columns
+	const float a = transform[0].x, b = transform[1].x, c = transform[2].x;
+	const float d = transform[0].y, e = transform[1].y, f = transform[2].y;
+	const float g = transform[0].z, h = transform[1].z, i = transform[2].z;
+	const float cofactor_a = e * i - f * h;
+	const float cofactor_b = f * g - d * i;
+	const float cofactor_c = d * h - e * g;
+	const float inv_determinant = 1.0f / (a * cofactor_a + b * cofactor_b + c * cofactor_c);
+
+	maths::Matrix4f inverse = maths::Matrix4f::identity();
+	inverse[0] = maths::Vector4f(cofactor_a, cofactor_b, cofactor_c, 0.0f);
+	inverse[1] = maths::Vector4f(c * h - b * i, a * i - c * g, b * g - a * h, 0.0f);
+	inverse[2] = maths::Vector4f(b * f - c * e, c * d - a * f, a * e - b * d, 0.0f);
+	for (int column = 0; column < 3; ++column)
+	{
+		inverse[column].x *= inv_determinant;
+		inverse[column].y *= inv_determinant;
+		inverse[column].z *= inv_determinant;
+	}
+
+	// Then undo the translation
+	const maths::Vector3f translation(transform[3].x, transform[3].y, transform[3].z);
+	const maths::Vector3f inverse_translation = TransformDirection(inverse, translation);
+	inverse[3] = maths::Vector4f(-inverse_translation.x, -inverse_translation.y, -inverse_translation.z, 1.0f);
+	return inverse;
+}
+
+maths::AABB3 TransformBounds(const maths::Matrix4f& transform, const maths::AABB3& bounds)
+{
+	// Each coefficient of the linear part moves the new bounds by the
+	// smaller and the larger of its products with the old ones
+	maths::Vector3f bounds_min(transform[3].x, transform[3].y, transform[3].z);
+	maths::Vector3f bounds_max = bounds_min;
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int column = 0; column < 3; ++column)
+		{
+			const float coefficient = transform[column][row];
+			const float low = coefficient * bounds.bottom_left()[column];
+			const float high = coefficient * bounds.top_right()[column];
+			bounds_min[row] += std::min(low, high);
+			bounds_max[row] += std::max(low, high);
+		}
+	}
+	return { bounds_min, bounds_max };
+}
+
+void Model::Build()
+{
+	std::vector<maths::AABB3> primitive_bounds;
+	primitive_bounds.reserve(primitive_count());
+	for (std::size_t i = 0; i < spheres.size(); ++i)
+	{
+		primitive_bounds.push_back(spheres.bounds(i));
+	}
+	for (std::size_t i = 0; i < triangles.triangle_count(); ++i)
+	{
+		primitive_bounds.push_back(triangles.bounds(i));
+	}
+	bvh.Build(primitive_bounds);
+	spheres.Reorder(bvh.RenumberPrimitives(spheres.size()));
+	if (!bvh.empty())
+	{
+		bounds = maths::AABB3(bvh.nodes()[0].bounds_min, bvh.nodes()[0].bounds_max);
+	}
+}
+
+bool Model::Intersect(
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance,
+	std::uint32_t& primitive) const
+{
+	return bvh.Intersect(origin, direction, distance, [&](std::uint32_t index, float& closest_distance)
+	{
+		if (!IntersectPrimitive(spheres, triangles, index, origin, direction, closest_distance))
+		{
+			return false;
+		}
+		primitive = index;
+		return true;
+	});
+}
+
+bool Model::Occluded(
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float max_distance) const
+{
+	return bvh.Occluded(origin, direction, max_distance, [&](std::uint32_t index)
+	{
+		float distance = max_distance;
+		return IntersectPrimitive(spheres, triangles, index, origin, direction, distance);
+	});
+}
+
+std::size_t Model::memory_size() const
+{
+	return spheres.size() * (4 * sizeof(float) + sizeof(std::uint32_t))
+		+ triangles.memory_size()
+		+ bvh.nodes().size() * sizeof(BvhNode)
+		+ bvh.primitive_indices().size() * sizeof(std::uint32_t);
+}
+
+void Instance::SetTransform(const maths::Matrix4f& object_to_world, const Model& placed_model)
+{
+	transform = object_to_world;
+	inverse_transform = AffineInverse(object_to_world);
+	bounds = TransformBounds(object_to_world, placed_model.bounds);
+}
+
+}// namespace raytracing
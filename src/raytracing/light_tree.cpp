@@ -0,0 +1,177 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "raytracing/light_tree.h"
+
+namespace raytracing {
+
+namespace {
+
+// Choose between two weights with u, then rescale u to [0, 1)
+// so it can be used again for the next choice
+bool ChooseFirst(float first_weight, float second_weight, float& u, float& probability)
+{
+	const float total = first_weight + second_weight;
+	const float first_probability = total > 0.0f ? first_weight / total : 0.5f;
+	if (u < first_probability)
+	{
+		u = std::min(u / first_probability, std::nextafter(1.0f, 0.0f));
+		probability = first_probability;
+		return true;
+	}
+	u = std::min((u - first_probability) / (1.0f - first_probability), std::nextafter(1.0f, 0.0f));
+	probability = 1.0f - first_probability;
+	return false;
+}
+
+}// namespace
+
+void LightTree::Build(std::span<const PointLight> lights)
+{
+	lights_.assign(lights.begin(), lights.end());
+	node_intensities_.clear();
+	node_falloff_radii_.clear();
+
+	// Lights are points, a small extent keeps the surface area heuristic
+	// meaningful when they are aligned
+	const maths::Vector3f extent(1e-3f, 1e-3f, 1e-3f);
+	std::vector<maths::AABB3> bounds;
+	bounds.reserve(lights_.size());
+	for (const PointLight& light : lights_)
+	{
+		bounds.emplace_back(light.position - extent, light.position + extent);
+	}
+	bvh_.Build(bounds);
+
+	// Children are always stored after their parent, so a reverse sweep
+	// visits them first
+	const std::vector<BvhNode>& nodes = bvh_.nodes();
+	node_intensities_.resize(nodes.size());
+	node_falloff_radii_.resize(nodes.size());
+	for (std::size_t i = nodes.size(); i-- > 0;)
+	{
+		const BvhNode& node = nodes[i];
+		float intensity = 0.0f;
+		float falloff_radius = 0.0f;
+		if (node.IsLeaf())
+		{
+			for (std::uint32_t j = 0; j < node.primitive_count; ++j)
+			{
+				const PointLight& light = lights_[bvh_.primitive_indices()[node.left_first + j]];
+				intensity += light.intensity;
+				falloff_radius = std::max(falloff_radius, light.falloff_radius);
+			}
+		}
+		else
+		{
+			for (std::uint32_t child = node.left_first; child < node.left_first + 2; ++child)
+			{
+				intensity += node_intensities_[child];
+				falloff_radius = std::max(falloff_radius, node_falloff_radii_[child]);
+			}
+		}
+		node_intensities_[i] = intensity;
+		node_falloff_radii_[i] = falloff_radius;
+	}
+}
+
+float LightTree::NodeImportance(std::uint32_t node_index, const maths::Vector3f& position) const
+{
+	const BvhNode& node = bvh_.nodes()[node_index];
+	float squared_distance = 0.0f;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float outside = std::max({ node.bounds_min[axis] - position[axis],
+			position[axis] - node.bounds_max[axis], 0.0f });
+		squared_distance += outside * outside;
+	}
+	return node_intensities_[node_index]
+		* PointLight::Attenuation(squared_distance, node_falloff_radii_[node_index]);
+}
+
+float LightTree::LightImportance(std::uint32_t light_index, const maths::Vector3f& position) const
+{
+	const PointLight& light = lights_[light_index];
+	return light.intensity
+		* PointLight::Attenuation((light.position - position).SqrMagnitude(), light.falloff_radius);
+}
+
+std::uint32_t LightTree::Sample(const maths::Vector3f& position, float u, float& pdf) const
+{
+	pdf = 1.0f;
+	const std::vector<BvhNode>& nodes = bvh_.nodes();
+	std::uint32_t node_index = 0;
+	while (!nodes[node_index].IsLeaf())
+	{
+		const std::uint32_t left_index = nodes[node_index].left_first;
+		float probability;
+		const bool left = ChooseFirst(NodeImportance(left_index, position),
+			NodeImportance(left_index + 1, position), u, probability);
+		pdf *= probability;
+		node_index = left ? left_index : left_index + 1;
+	}
+
+	// Pick among the few lights of the leaf by their own importance
+	const BvhNode& leaf = nodes[node_index];
+	const std::uint32_t* light_indices = bvh_.primitive_indices().data() + leaf.left_first;
+	float total = 0.0f;
+	for (std::uint32_t i = 0; i < leaf.primitive_count; ++i)
+	{
+		total += LightImportance(light_indices[i], position);
+	}
+	if (total <= 0.0f)
+	{
+		// No light carries any weight, pick them uniformly
+		pdf /= static_cast<float>(leaf.primitive_count);
+		return light_indices[std::min(leaf.primitive_count - 1,
+			static_cast<std::uint32_t>(u * leaf.primitive_count))];
+	}
+	float remaining = u * total;
+	std::uint32_t chosen = 0;
+	float chosen_importance = 0.0f;
+	for (std::uint32_t i = 0; i < leaf.primitive_count; ++i)
+	{
+		const float importance = LightImportance(light_indices[i], position);
+		if (importance <= 0.0f)
+		{
+			continue;
+		}
+		// Rounding may leave a bit of remaining weight, the last light
+		// with some importance is then kept
+		chosen = i;
+		chosen_importance = importance;
+		if (remaining < importance)
+		{
+			break;
+		}
+		remaining -= importance;
+	}
+	pdf *= chosen_importance / total;
+	return light_indices[chosen];
+}
+
+}// namespace raytracing
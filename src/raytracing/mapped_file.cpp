@@ -0,0 +1,179 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "raytracing/mapped_file.h"
+
+namespace raytracing {
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		data_ = std::exchange(other.data_, nullptr);
+		size_ = std::exchange(other.size_, 0);
+		is_open_ = std::exchange(other.is_open_, false);
+#ifdef _WIN32
+		file_handle_ = std::exchange(other.file_handle_, nullptr);
+		mapping_handle_ = std::exchange(other.mapping_handle_, nullptr);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path, Access access)
+{
+	Close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL
+		| (access == Access::kSequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS), nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	file_handle_ = file;
+	size_ = static_cast<std::size_t>(file_size.QuadPart);
+	is_open_ = true;
+	// An empty file can not be mapped, it is open with no data
+	if (size_ == 0)
+	{
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+	mapping_handle_ = mapping;
+	data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (data_ == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data_ != nullptr)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_handle_ != nullptr)
+	{
+		CloseHandle(mapping_handle_);
+	}
+	if (file_handle_ != nullptr)
+	{
+		CloseHandle(file_handle_);
+	}
+	data_ = nullptr;
+	mapping_handle_ = nullptr;
+	file_handle_ = nullptr;
+	size_ = 0;
+	is_open_ = false;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path, Access access)
+{
+	Close();
+	const int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	struct stat file_stat;
+	if (fstat(file, &file_stat) != 0)
+	{
+		close(file);
+		return false;
+	}
+	size_ = static_cast<std::size_t>(file_stat.st_size);
+	if (size_ > 0)
+	{
+		void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data == MAP_FAILED)
+		{
+			close(file);
+			size_ = 0;
+			return false;
+		}
+		madvise(data, size_, access == Access::kSequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+		data_ = static_cast<const char*>(data);
+	}
+	// The mapping keeps its own reference on the file
+	close(file);
+	is_open_ = true;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data_ != nullptr)
+	{
+		munmap(const_cast<char*>(data_), size_);
+	}
+	data_ = nullptr;
+	size_ = 0;
+	is_open_ = false;
+}
+
+#endif
+
+}// namespace raytracing
@@ -22,68 +22,112 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
-#include <omp.h>
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
 
 #include "raytracing/ray_tracer.h"
+#include "raytracing/sampling.h"
 
 namespace raytracing {
 
-inline
-	float clamp(float& rgb_value)
+namespace {
+
+// Hit of the front side of a plane, only if closer than distance
+bool IntersectPlane(
+	const maths::Plane& plane,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance)
 {
-	if (rgb_value > 255.0f)
+	RAYTRACING_STAT(intersection_tests, 1);
+	const float facing = maths::Vector3f::Dot(direction, plane.normal());
+	if (facing >= 0.0f)
 	{
-		rgb_value = 255.0f;
+		return false;
 	}
-	if (rgb_value < 0.0f)
+	const float hit_distance = -plane.Distance(origin) / facing;
+	if (hit_distance <= 0.0f || hit_distance >= distance)
 	{
-		rgb_value = 0.0f;
-	}
-	return rgb_value;
+		return false;
 	}
+	distance = hit_distance;
+	return true;
+}
+
+}// namespace
 
 bool Raytracer::ObjectIntersect(
 	maths::Ray3& ray,
-	Material& hit_material, 
 	HitInfos& hit_info, 
-	float& distance)
+	float& distance,
+	bool primary_ray)
 {
 	float max_distance = 1000000.0f;
 	distance = max_distance;
-	for (int i = 0; i < spheres_.size(); ++i)
+
+	// Only keep the intersection with the nearest sphere or triangle,
+	// if distance is smaller than previously
+	const maths::Vector3f origin = ray.origin();
+	const maths::Vector3f direction = ray.direction();
+	std::uint32_t hit_index = 0;
+	auto intersect_primitive = [&](std::uint32_t index, float& closest_distance)
 	{
-		hit_info.distance = max_distance;
-		// Only render intersection for the nearest sphere,
-		// if distance is smaller than previously
-		if (ray.IntersectSphere(spheres_[i], hit_info.hit_position, hit_info.distance)
-			&& hit_info.distance < distance)
+		if (!IntersectPrimitive(index, origin, direction, closest_distance))
 		{
-			//Set hit info value regarding the object that was hit
-			hit_info.normal = maths::Vector3f(hit_info.hit_position - spheres_[i].center()).Normalized();
-			hit_material = spheres_[i].material();
-			distance = hit_info.distance;
+			return false;
 		}
+		hit_index = index;
+		return true;
+	};
+
+	bool has_hit;
+	if (acceleration_ == Acceleration::kBvh)
+	{
+		has_hit = bvh_.Intersect(origin, direction, distance, intersect_primitive);
 	}
-	if (distance != max_distance)
+	else if (primary_ray)
 	{
-		// Means that the ray had an intersection
-		return true;
+		has_hit = false;
+		for (const std::uint32_t index : visible_primitives_)
+		{
+			has_hit |= intersect_primitive(index, distance);
+		}
 	}
-
-	if (planes_.size() != 0)
+	else
 	{
-		for (int i = 0; i < planes_.size(); ++i)
+		has_hit = false;
+		const std::uint32_t primitive_count = PrimitiveCount();
+		for (std::uint32_t i = 0; i < primitive_count; ++i)
 		{
-			if (ray.IntersectPlane(planes_[i], hit_info.hit_position))
-			{
-				hit_info.normal = planes_[i].normal();
-				hit_material = planes_[i].material();
-
-				return true;
-			}
+			has_hit |= intersect_primitive(i, distance);
 		}
 	}
+	// The instances only report hits closer than the one already found
+	InstanceHit instance_hit;
+	const bool has_instance_hit = IntersectInstances(origin, direction, distance, instance_hit);
+	// Planes are infinite and stay out of the hierarchies,
+	// they are tested last against the closest hit so far
+	std::uint32_t plane_index;
+	const bool has_plane_hit = IntersectPlanes(origin, direction, distance, plane_index);
+	hit_info.distance = distance;
+	if (has_plane_hit)
+	{
+		ResolvePlaneHit(plane_index, origin, direction, hit_info);
+		return true;
+	}
+	if (has_instance_hit)
+	{
+		ResolveInstanceHit(instance_hit, origin, direction, hit_info);
+		return true;
+	}
+	if (has_hit)
+	{
+		//Set hit info value regarding the object that was hit
+		ResolveHit(hit_index, origin, direction, hit_info);
+		return true;
+	}
 	return false;
 }
 
@@ -92,106 +136,975 @@ maths::Vector3f Raytracer::RayCast(
 	const maths::Vector3f& ray_direction, 
 	const int& depth)
 {
+	RAYTRACING_STAT(primary_rays, depth == 0 ? 1 : 0);
 	maths::Ray3 ray{ origin, ray_direction };
-	Material hit_object_material;
 	HitInfos hit_info;
 	float distance;
-	bool in_light = true;
 
-	//If the ray didn't hit anything or if the recursive depth of the raycasting
-	// is greater than 4, return background color
-	if (depth > 4 || !ObjectIntersect(ray, hit_object_material, hit_info, distance))
+	//If the ray didn't hit anything or if the depth of the raycasting
+	// is greater than the maximum depth, return background color
+	if (depth > max_depth_ || !ObjectIntersect(ray, hit_info, distance,
+		depth == 0 && primary_rays_culled_))
 	{
 		return background_color_;
 	}
-	else
+	return TracePath(ray_direction, hit_info, depth);
+}
+
+bool Raytracer::DirectLight(const HitInfos& hit_info, float& light_value)
+{
+	light_value = 0.0f;
+	bool is_lit = false;
+	auto add_light = [&](const PointLight& light, float weight)
 	{
 		//Compute the normal or direction of the light
-		maths::Vector3f light_normal(light_.position - hit_info.hit_position);
-		light_normal.Normalize();
+		maths::Vector3f light_normal(light.position - hit_info.hit_position);
+		const float light_distance = light_normal.Magnitude();
+		light_normal /= light_distance;
 
 		//Compute shadow ray to check if point is in shadow
-		in_light = ShadowRay(hit_info.hit_position, hit_info.normal, light_normal);
+		if (!ShadowRay(hit_info.hit_position, hit_info.normal, light_normal, light_distance))
+		{
+			return;
+		}
+		is_lit = true;
 
 		// Calculate how much light is the point getting
-		float light_value = maths::Vector3f::Dot(hit_info.normal, light_normal);
-		if (light_value < 0.0f)
+		float cosine = maths::Vector3f::Dot(hit_info.normal, light_normal);
+		if (cosine < 0.0f)
 		{
-			light_value = 0.0f;
+			cosine = 0.0f;
 		}
+		light_value += cosine * light.intensity * weight
+			* PointLight::Attenuation(light_distance * light_distance, light.falloff_radius);
+	};
 
-		if (in_light)
+	if (lights_.size() <= static_cast<std::size_t>(light_sample_count_))
+	{
+		for (const PointLight& light : lights_)
 		{
-			// Point is not in the shadow
-			// Cast reflexion ray recursively to compute reflexion color
-			const maths::Vector3f reflection_direction = Reflect(ray_direction, hit_info.normal).Normalized();
-			const maths::Vector3f reflection_origin(hit_info.hit_position + hit_info.normal * bias_);
-			const maths::Vector3f reflection_color = RayCast(reflection_origin, reflection_direction, depth + 1);
-			hit_object_material.set_color(hit_object_material.color() * light_value 
-				+= reflection_color * hit_object_material.reflexion_index());
+			add_light(light, 1.0f);
 		}
-		else
+		return is_lit;
+	}
+
+	// The random numbers only depend on the hit, so the image does not
+	// depend on the thread that traced it
+	const maths::Vector3f& position = hit_info.hit_position;
+	Rng rng(HashSeed(std::bit_cast<std::uint32_t>(position.x),
+		std::bit_cast<std::uint32_t>(position.y),
+		std::bit_cast<std::uint32_t>(position.z)));
+	for (int i = 0; i < light_sample_count_; ++i)
+	{
+		float pdf;
+		const std::uint32_t light_index = light_tree_.Sample(position, rng.NextFloat(), pdf);
+		add_light(lights_[light_index], 1.0f / (pdf * light_sample_count_));
+	}
+	return is_lit;
+}
+
+maths::Vector3f Raytracer::TracePath(
+	maths::Vector3f ray_direction,
+	HitInfos hit_info,
+	int depth)
+{
+	maths::Vector3f color(0.0f, 0.0f, 0.0f);
+	// Part of the color of the current hit that reaches the pixel
+	float throughput = 1.0f;
+	while (true)
+	{
+		//Compute the light reaching the point, a point in the shadow
+		//of every light is black and casts no reflexion
+		float light_value;
+		if (!DirectLight(hit_info, light_value))
 		{
-			//Point is in the shadow
-			hit_object_material.set_color(hit_object_material.color() * light_value * in_light);
+			break;
 		}
-		return (hit_object_material.color());
+		const Material& material = materials_[hit_info.material_index];
+		color += material.color() * light_value * throughput;
+
+		// Stop when the reflexion can no longer change the color
+		throughput *= material.reflexion_index();
+		if (throughput <= min_contribution_)
+		{
+			break;
+		}
+
+		// Follow the reflexion ray
+		RAYTRACING_STAT(reflection_rays, 1);
+		const maths::Vector3f reflection_origin(hit_info.hit_position + hit_info.normal * bias_);
+		ray_direction = Reflect(ray_direction, hit_info.normal).Normalized();
+		maths::Ray3 reflection_ray{ reflection_origin, ray_direction };
+		float distance;
+		if (++depth > max_depth_
+			|| !ObjectIntersect(reflection_ray, hit_info, distance))
+		{
+			color += background_color_ * throughput;
+			break;
+		}
+	}
+	return color;
+}
+
+void Raytracer::SetScene(
+	std::span<const maths::Sphere> spheres,
+	std::span<const maths::Plane> planes,
+	std::span<const Material> materials,
+	const PointLight light,
+	const int& heigth,
+	const int& width,
+	const float& fov,
+	const double& bias)
+{
+	SetSpheres(spheres);
+	planes_.assign(planes.begin(), planes.end());
+	materials_.assign(materials.begin(), materials.end());
+	SetView(light, heigth, width, fov, bias);
+}
+
+void Raytracer::SetScene(
+	std::span<const maths::Sphere> spheres,
+	std::vector<maths::Plane>&& planes,
+	std::vector<Material>&& materials,
+	const PointLight light,
+	const int& heigth,
+	const int& width,
+	const float& fov,
+	const double& bias)
+{
+	SetSpheres(spheres);
+	planes_ = std::move(planes);
+	materials_ = std::move(materials);
+	SetView(light, heigth, width, fov, bias);
+}
+
+void Raytracer::SetScene(
+	SphereArrays&& spheres,
+	std::vector<Material>&& materials,
+	std::vector<maths::Plane>&& planes,
+	const PointLight light,
+	const int& heigth,
+	const int& width,
+	const float& fov,
+	const double& bias)
+{
+	spheres_ = std::move(spheres);
+	materials_ = std::move(materials);
+	planes_ = std::move(planes);
+	SetView(light, heigth, width, fov, bias);
+}
+
+void Raytracer::SetScene(const SceneFile& scene)
+{
+	spheres_.center_x.assign(scene.sphere_center_x().begin(), scene.sphere_center_x().end());
+	spheres_.center_y.assign(scene.sphere_center_y().begin(), scene.sphere_center_y().end());
+	spheres_.center_z.assign(scene.sphere_center_z().begin(), scene.sphere_center_z().end());
+	spheres_.radius.assign(scene.sphere_radius().begin(), scene.sphere_radius().end());
+	spheres_.material_index.assign(scene.sphere_material_index().begin(), scene.sphere_material_index().end());
+
+	materials_.clear();
+	materials_.reserve(scene.materials().size());
+	for (const SceneMaterialRecord& material : scene.materials())
+	{
+		materials_.emplace_back(material.reflexion_index,
+			maths::Vector3f(material.color[0], material.color[1], material.color[2]));
+	}
+	planes_.clear();
+	planes_.reserve(scene.planes().size());
+	for (const ScenePlane& scene_plane : scene.planes())
+	{
+		maths::Plane plane(scene_plane.point, scene_plane.normal);
+		plane.set_material_index(scene_plane.material_index);
+		planes_.push_back(plane);
+	}
+	std::vector<PointLight> lights;
+	lights.reserve(scene.lights().size());
+	for (const SceneLightRecord& record : scene.lights())
+	{
+		PointLight light;
+		light.position = maths::Vector3f(record.position[0], record.position[1], record.position[2]);
+		light.intensity = record.intensity;
+		light.falloff_radius = record.falloff_radius;
+		lights.push_back(light);
+	}
+
+	const bool has_bvh = !scene.bvh_nodes().empty();
+	SetView(PointLight(), scene.height(), scene.width(),
+		scene.camera().fov().value(), scene.bias(), !has_bvh);
+	if (has_bvh)
+	{
+		bvh_.Assign(scene.bvh_nodes(), scene.bvh_primitive_indices());
+	}
+	//The lights of the file replace the one of the view, a file without
+	//lights renders without any
+	SetLights(std::move(lights));
+	set_camera(scene.camera());
+}
+
+void Raytracer::SetView(
+	const PointLight& light,
+	int heigth,
+	int width,
+	float fov,
+	double bias,
+	bool build_bvh)
+{
+	lights_.assign(1, light);
+	light_tree_.Build(lights_);
+	triangles_.clear();
+	mesh_first_triangles_.clear();
+	mesh_material_indices_.clear();
+	models_.clear();
+	instances_.clear();
+	instance_bvh_.Clear();
+	instances_changed_ = false;
+	height_ = heigth;
+	width_ = width;
+	camera_ = Camera(maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Matrix4f::identity(), maths::radian_t(fov), 0.0f);
+	camera_.Prepare(width_, height_);
+	bias_ = bias;
+	frame_buffer_.assign(static_cast<std::size_t>(width_) * height_, maths::Vector3f());
+	ResetProgressive();
+	if (build_bvh)
+	{
+		BuildBvh();
 	}
 }
 
 void Raytracer::Render()
 {
-#pragma omp parallel for
-	for (int i = 0; i < height_; ++i)
+	RenderInto(frame_buffer_);
+}
+
+bool Raytracer::RenderInto(std::span<maths::Vector3f> output)
+{
+	if (output.size() != static_cast<std::size_t>(width_) * height_)
+	{
+		return false;
+	}
+	render_target_ = output;
+	CullPrimitives();
+	RunTiles([this](const TileStats& tile)
+	{
+		RenderTile(tile);
+	});
+	primary_rays_culled_ = false;
+	return true;
+}
+
+void Raytracer::SetLights(std::vector<PointLight>&& lights)
+{
+	lights_ = std::move(lights);
+	light_tree_.Build(lights_);
+	ResetProgressive();
+}
+
+void Raytracer::set_camera(const Camera& camera)
+{
+	camera_ = camera;
+	camera_.Prepare(width_, height_);
+	ResetProgressive();
+}
+
+void Raytracer::ResetProgressive()
+{
+	const std::size_t pixel_count = static_cast<std::size_t>(width_) * height_;
+	accumulation_.assign(pixel_count, maths::Vector3f());
+	luminance_sum_.assign(pixel_count, 0.0f);
+	luminance_square_sum_.assign(pixel_count, 0.0f);
+	sample_counts_.assign(pixel_count, 0);
+	progressive_pass_count_ = 0;
+}
+
+int Raytracer::RenderPass()
+{
+	std::atomic<int> traced_pixels{ 0 };
+	CullPrimitives();
+	RunTiles([&](const TileStats& tile)
+	{
+		traced_pixels += RenderTilePass(tile);
+	});
+	primary_rays_culled_ = false;
+	++progressive_pass_count_;
+	return traced_pixels;
+}
+
+int Raytracer::RenderProgressive(std::chrono::milliseconds time_budget, int max_passes)
+{
+	const auto start = std::chrono::steady_clock::now();
+	int passes = 0;
+	while (passes < max_passes)
+	{
+		++passes;
+		if (RenderPass() == 0 || std::chrono::steady_clock::now() - start >= time_budget)
+		{
+			break;
+		}
+	}
+	return passes;
+}
+
+bool Raytracer::IsPixelConverged(std::size_t pixel) const
+{
+	const std::uint32_t count = sample_counts_[pixel];
+	if (count < min_samples_)
+	{
+		return false;
+	}
+	// Variance of the mean luminance of the pixel
+	const float mean = luminance_sum_[pixel] / count;
+	const float variance = std::max(0.0f, luminance_square_sum_[pixel] / count - mean * mean);
+	return variance / count <= variance_threshold_ * variance_threshold_;
+}
+
+int Raytracer::RenderTilePass(const TileStats& tile)
+{
+	const maths::Vector3f& origin = camera_.position();
+	int traced_pixels = 0;
+	for (int i = tile.y; i < tile.y + tile.height; ++i)
+	{
+		for (int j = tile.x; j < tile.x + tile.width; ++j)
+		{
+			const std::size_t pixel = j + static_cast<std::size_t>(i) * width_;
+			if (IsPixelConverged(pixel))
+			{
+				continue;
+			}
+			// The first sample goes through the center of the pixel,
+			// the next ones are spread randomly inside of it
+			const std::uint32_t sample = sample_counts_[pixel];
+			float offset_x = 0.5f;
+			float offset_y = 0.5f;
+			if (sample > 0)
+			{
+				Rng rng(HashSeed(pixel, sample, sample_seed_));
+				offset_x = rng.NextFloat();
+				offset_y = rng.NextFloat();
+			}
+			const maths::Vector3f color = RayCast(origin, PrimaryRayDirection(i, j, offset_x, offset_y));
+
+			const float luminance = 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z;
+			accumulation_[pixel] += color;
+			luminance_sum_[pixel] += luminance;
+			luminance_square_sum_[pixel] += luminance * luminance;
+			sample_counts_[pixel] = sample + 1;
+			frame_buffer_[pixel] = accumulation_[pixel] / static_cast<float>(sample + 1);
+			++traced_pixels;
+		}
+	}
+	return traced_pixels;
+}
+
+void Raytracer::RunTiles(const std::function<void(const TileStats&)>& render_tile)
+{
+	if (instances_changed_)
+	{
+		UpdateInstances();
+	}
+	const std::size_t wanted_thread_count = thread_count_ == 0
+		? std::max(1u, std::thread::hardware_concurrency())
+		: thread_count_;
+	if (!thread_pool_ || thread_pool_->thread_count() != wanted_thread_count)
 	{
-		for (int j = 0; j < width_; ++j)
+		thread_pool_ = std::make_unique<threading::ThreadPool>(wanted_thread_count);
+	}
+
+	const int tile_size = std::max(1, tile_size_);
+	tile_stats_.clear();
+	for (int y = 0; y < height_; y += tile_size)
+	{
+		for (int x = 0; x < width_; x += tile_size)
+		{
+			tile_stats_.push_back({
+				.x = x,
+				.y = y,
+				.width = std::min(tile_size, width_ - x),
+				.height = std::min(tile_size, height_ - y),
+				.milliseconds = 0.0,
+				.counters = {} });
+		}
+	}
+
+	const auto frame_start = std::chrono::steady_clock::now();
+	thread_pool_->ParallelFor(tile_stats_.size(), [&](std::size_t tile_index)
+	{
+		TileStats& tile = tile_stats_[tile_index];
+		if constexpr (kRenderStatsEnabled)
+		{
+			ThreadRenderStats() = RenderStats();
+		}
+		const auto start = std::chrono::steady_clock::now();
+		render_tile(tile);
+		const auto end = std::chrono::steady_clock::now();
+		tile.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+		if constexpr (kRenderStatsEnabled)
+		{
+			tile.counters = ThreadRenderStats();
+			tile.counters.milliseconds = tile.milliseconds;
+		}
+	});
+
+	// Each tile was counted by a single thread, they are merged once the frame is done
+	if constexpr (kRenderStatsEnabled)
+	{
+		render_stats_ = RenderStats();
+		for (const TileStats& tile : tile_stats_)
 		{
-			double dir_x = (j + 0.5f) - width_ / 2.0;
-			double dir_y = -(i + 0.5f) + height_ / 2.0;
-			double dir_z = -height_ / (2.0 * tan(fov_ / 2.0));
+			render_stats_ += tile.counters;
+		}
+		render_stats_.milliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - frame_start).count();
+	}
+}
 
-			maths::Vector3f ray_direction = maths::Vector3f(dir_x, dir_y, dir_z).Normalized();
+maths::Vector3f Raytracer::PrimaryRayDirection(int row, int column) const
+{
+	return PrimaryRayDirection(row, column, 0.5f, 0.5f);
+}
+
+maths::Vector3f Raytracer::PrimaryRayDirection(int row, int column, float offset_x, float offset_y) const
+{
+	return camera_.RayDirection(column + offset_x, row + offset_y);
+}
 
-			frame_buffer_[j + i * width_] = RayCast(maths::Vector3f(0.0f, 0.0f, 0.0f),
-				ray_direction);
+void Raytracer::RenderTile(const TileStats& tile)
+{
+	if (samples_per_pixel_ > 1)
+	{
+		RenderTileSupersampled(tile);
+	}
+	else if (render_mode_ == RenderMode::kPacket)
+	{
+		RenderTilePackets(tile);
+	}
+	else
+	{
+		// Same directions as PrimaryRayDirection, the start
+		// of the row being computed once
+		const maths::Vector3f& origin = camera_.position();
+		for (int i = tile.y; i < tile.y + tile.height; ++i)
+		{
+			const maths::Vector3f row_start = camera_.RowStart(i + 0.5f);
+			for (int j = tile.x; j < tile.x + tile.width; ++j)
+			{
+				render_target_[j + i * width_] = RayCast(origin,
+					camera_.RowDirection(row_start, j + 0.5f).Normalized());
+			}
 		}
 	}
-	WriteImage();
 }
 
-void Raytracer::WriteImage()
+void Raytracer::RenderTileSupersampled(const TileStats& tile)
 {
-	std::ofstream ofs("./image.ppm", std::ios::out | std::ios::binary);
-	ofs << "P6\n" << width_ << " " << height_ << "\n255\n";
-	for (uint32_t i = 0; i < height_ * width_; ++i) {
-		char r = (char)(clamp(frame_buffer_[i].x));
-		char g = (char)(clamp(frame_buffer_[i].y));
-		char b = (char)(clamp(frame_buffer_[i].z));
+	const maths::Vector3f& origin = camera_.position();
+	const int sample_count = samples_per_pixel_;
+	int columns;
+	int rows;
+	StratificationGrid(sample_count, columns, rows);
+	for (int i = tile.y; i < tile.y + tile.height; ++i)
+	{
+		for (int j = tile.x; j < tile.x + tile.width; ++j)
+		{
+			// Each pixel has its own generator and sums its samples in
+			// the same order, so the image does not depend on the threads
+			const std::size_t pixel = j + static_cast<std::size_t>(i) * width_;
+			Rng rng(HashSeed(pixel, sample_seed_));
+			maths::Vector3f color(0.0f, 0.0f, 0.0f);
+			for (int first = 0; first < sample_count; first += kPacketSize)
+			{
+				const int batch_size = std::min(kPacketSize, sample_count - first);
+				maths::Vector3f directions[kPacketSize];
+				for (int k = 0; k < batch_size; ++k)
+				{
+					const int sample = first + k;
+					const float offset_x = (sample % columns + rng.NextFloat()) / columns;
+					const float offset_y = (sample / columns + rng.NextFloat()) / rows;
+					directions[k] = PrimaryRayDirection(i, j, offset_x, offset_y);
+				}
 
-		ofs << r << g << b;
+				if (render_mode_ == RenderMode::kPacket)
+				{
+					// The samples of a pixel are coherent, they make a packet
+					RayPacket packet;
+					for (int lane = 0; lane < kPacketSize; ++lane)
+					{
+						packet.Set(lane, origin, directions[std::min(lane, batch_size - 1)]);
+					}
+					maths::Vector3f colors[kPacketSize];
+					TracePacket(packet, (1 << batch_size) - 1, colors);
+					for (int k = 0; k < batch_size; ++k)
+					{
+						color += colors[k];
+					}
+				}
+				else
+				{
+					for (int k = 0; k < batch_size; ++k)
+					{
+						color += RayCast(origin, directions[k]);
+					}
+				}
+			}
+			render_target_[pixel] = color / static_cast<float>(sample_count);
+		}
 	}
-	ofs.close();
+}
+
+void Raytracer::RenderTilePackets(const TileStats& tile)
+{
+	const maths::Vector3f& origin = camera_.position();
+	for (int i = tile.y; i < tile.y + tile.height; i += 2)
+	{
+		for (int j = tile.x; j < tile.x + tile.width; j += 2)
+		{
+			// Lanes falling outside of the tile stay inactive
+			RayPacket packet;
+			int active_mask = 0;
+			for (int lane = 0; lane < kPacketSize; ++lane)
+			{
+				const int row = i + lane / 2;
+				const int column = j + lane % 2;
+				if (row < tile.y + tile.height && column < tile.x + tile.width)
+				{
+					packet.Set(lane, origin, PrimaryRayDirection(row, column));
+					active_mask |= 1 << lane;
+				}
+				else
+				{
+					packet.Set(lane, origin, maths::Vector3f(0.0f, 0.0f, -1.0f));
+				}
+			}
+
+			maths::Vector3f colors[kPacketSize];
+			TracePacket(packet, active_mask, colors);
+			for (int lane = 0; lane < kPacketSize; ++lane)
+			{
+				if (active_mask & (1 << lane))
+				{
+					render_target_[(j + lane % 2) + (i + lane / 2) * width_] = colors[lane];
+				}
+			}
+		}
+	}
+}
+
+void Raytracer::TracePacket(const RayPacket& packet, int active_mask, maths::Vector3f* colors)
+{
+	RAYTRACING_STAT(primary_rays, std::popcount(static_cast<unsigned>(active_mask)));
+	PacketHit hit;
+	hit.Reset(1000000.0f);
+	auto intersect_primitive = [&](std::uint32_t index, int mask)
+	{
+		RAYTRACING_STAT(intersection_tests, std::popcount(static_cast<unsigned>(mask)));
+		if (index < spheres_.size())
+		{
+			return IntersectSpherePacket(spheres_.center(index), spheres_.radius[index],
+				static_cast<std::int32_t>(index), packet, hit, mask);
+		}
+		// Triangles are tested one ray at a time
+		int hit_mask = 0;
+		for (int lane = 0; lane < kPacketSize; ++lane)
+		{
+			if ((mask & (1 << lane))
+				&& IntersectTriangle(triangles_, index - spheres_.size(),
+					packet.origin(lane), packet.direction(lane), hit.distance[lane]))
+			{
+				hit.primitive[lane] = static_cast<std::int32_t>(index);
+				hit_mask |= 1 << lane;
+			}
+		}
+		return hit_mask;
+	};
+	if (acceleration_ == Acceleration::kBvh)
+	{
+		bvh_.IntersectPacket(packet, hit, active_mask, intersect_primitive);
+	}
+	else
+	{
+		for (const std::uint32_t index : visible_primitives_)
+		{
+			intersect_primitive(index, active_mask);
+		}
+	}
+
+	// Shading diverges between the rays, it continues one ray at a time
+	for (int lane = 0; lane < kPacketSize; ++lane)
+	{
+		if (!(active_mask & (1 << lane)))
+		{
+			continue;
+		}
+		const maths::Vector3f origin = packet.origin(lane);
+		const maths::Vector3f direction = packet.direction(lane);
+		// Instances and planes are tested one ray at a time, against the
+		// closest hit of the packet
+		float distance = hit.distance[lane];
+		InstanceHit instance_hit;
+		const bool has_instance_hit = IntersectInstances(origin, direction, distance, instance_hit);
+		std::uint32_t plane_index;
+		const bool has_plane_hit = IntersectPlanes(origin, direction, distance, plane_index);
+		HitInfos hit_info;
+		hit_info.distance = distance;
+		if (has_plane_hit)
+		{
+			ResolvePlaneHit(plane_index, origin, direction, hit_info);
+		}
+		else if (has_instance_hit)
+		{
+			ResolveInstanceHit(instance_hit, origin, direction, hit_info);
+		}
+		else if (hit.primitive[lane] >= 0)
+		{
+			ResolveHit(hit.primitive[lane], origin, direction, hit_info);
+		}
+		else
+		{
+			colors[lane] = background_color_;
+			continue;
+		}
+		colors[lane] = TracePath(direction, hit_info, 0);
+	}
+}
+
+bool Raytracer::WriteImage()
+{
+	ConvertToRgb8(frame_buffer_, image_);
+	if (async_write_)
+	{
+		if (!image_writer_)
+		{
+			image_writer_ = std::make_unique<AsyncImageWriter>();
+		}
+		image_writer_->Write(output_path_, width_, height_, std::move(image_));
+		image_ = std::vector<std::uint8_t>();
+		return true;
+	}
+	return WritePpm(output_path_, width_, height_, image_);
+}
+
+bool Raytracer::FlushImages()
+{
+	return !image_writer_ || image_writer_->Flush();
+}
+
+bool Raytracer::Occluded(
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float max_distance) const
+{
+	auto occluded_by_primitive = [&](std::uint32_t index)
+	{
+		float distance = max_distance;
+		return IntersectPrimitive(index, origin, direction, distance);
+	};
+	if (acceleration_ == Acceleration::kBvh)
+	{
+		if (bvh_.Occluded(origin, direction, max_distance, occluded_by_primitive))
+		{
+			return true;
+		}
+	}
+	else
+	{
+		const std::uint32_t primitive_count = PrimitiveCount();
+		for (std::uint32_t i = 0; i < primitive_count; ++i)
+		{
+			if (occluded_by_primitive(i))
+			{
+				return true;
+			}
+		}
+	}
+
+	if (OccludedByInstances(origin, direction, max_distance))
+	{
+		return true;
+	}
+
+	for (const maths::Plane& plane : planes_)
+	{
+		float distance = max_distance;
+		if (IntersectPlane(plane, origin, direction, distance))
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 bool Raytracer::ShadowRay(
 	const maths::Vector3f& hit_position, 
 	const maths::Vector3f& hit_normal, 
-	const maths::Vector3f& light_normal)
+	const maths::Vector3f& light_normal,
+	float light_distance)
 {
+	RAYTRACING_STAT(shadow_rays, 1);
 	//Add a bias along the normal to prevent self collision
 	const maths::Vector3f shadow_ray_origin(hit_position + hit_normal * bias_);
-	maths::Ray3 shadow_ray(shadow_ray_origin, light_normal);
-	Material tmp_material;
-	HitInfos shadow_hit_info;
-	float tmp_distance;
-		
-	if (ObjectIntersect(shadow_ray, tmp_material, shadow_hit_info, tmp_distance))
-	{
-		// Return that the point is in the shadow
+	// Return true if the point is in the light
+	return !Occluded(shadow_ray_origin, light_normal, light_distance);
+}
+
+void Raytracer::SetSpheres(std::span<const maths::Sphere> spheres)
+{
+	spheres_.clear();
+	spheres_.reserve(spheres.size());
+	for (const maths::Sphere& sphere : spheres)
+	{
+		spheres_.push_back(sphere.center(), sphere.radius(), sphere.material_index());
+	}
+}
+
+void Raytracer::AddMesh(const TriangleMesh& mesh, const Material& material)
+{
+	mesh_first_triangles_.push_back(static_cast<std::uint32_t>(triangles_.Append(mesh)));
+	mesh_material_indices_.push_back(static_cast<std::uint32_t>(materials_.size()));
+	materials_.push_back(material);
+	BuildBvh();
+}
+
+bool Raytracer::IntersectPrimitive(
+	std::uint32_t index,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance) const
+{
+	return raytracing::IntersectPrimitive(spheres_, triangles_, index, origin, direction, distance);
+}
+
+void Raytracer::ResolveHit(
+	std::uint32_t index,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	HitInfos& hit_info) const
+{
+	hit_info.hit_position = origin + direction * hit_info.distance;
+	if (index < spheres_.size())
+	{
+		hit_info.normal = maths::Vector3f(hit_info.hit_position - spheres_.center(index)).Normalized();
+		hit_info.material_index = spheres_.material_index[index];
+		return;
+	}
+
+	// Triangles have no inside, their normal faces the ray
+	const std::size_t triangle = index - spheres_.size();
+	hit_info.normal = triangles_.normal(triangle);
+	if (maths::Vector3f::Dot(hit_info.normal, direction) > 0.0f)
+	{
+		hit_info.normal = hit_info.normal * -1.0f;
+	}
+	const auto mesh = std::upper_bound(mesh_first_triangles_.begin(), mesh_first_triangles_.end(),
+		static_cast<std::uint32_t>(triangle)) - mesh_first_triangles_.begin() - 1;
+	hit_info.material_index = mesh_material_indices_[mesh];
+}
+
+std::uint32_t Raytracer::AddModel(
+	std::span<const maths::Sphere> spheres,
+	const TriangleMesh& mesh,
+	const Material& mesh_material)
+{
+	Model& model = models_.emplace_back();
+	model.spheres.reserve(spheres.size());
+	for (const maths::Sphere& sphere : spheres)
+	{
+		model.spheres.push_back(sphere.center(), sphere.radius(), sphere.material_index());
+	}
+	model.triangles = mesh;
+	if (!mesh.empty())
+	{
+		model.triangle_material_index = static_cast<std::uint32_t>(materials_.size());
+		materials_.push_back(mesh_material);
+	}
+	model.Build();
+	return static_cast<std::uint32_t>(models_.size() - 1);
+}
+
+std::uint32_t Raytracer::AddInstance(std::uint32_t model, const maths::Matrix4f& transform)
+{
+	Instance& instance = instances_.emplace_back();
+	instance.model = model;
+	instance.SetTransform(transform, models_[model]);
+	instances_changed_ = true;
+	return static_cast<std::uint32_t>(instances_.size() - 1);
+}
+
+void Raytracer::SetInstanceTransform(std::uint32_t instance, const maths::Matrix4f& transform)
+{
+	instances_[instance].SetTransform(transform, models_[instances_[instance].model]);
+	instances_changed_ = true;
+}
+
+void Raytracer::UpdateInstances()
+{
+	std::vector<maths::AABB3>& bounds = instance_bounds_;
+	bounds.clear();
+	for (const Instance& instance : instances_)
+	{
+		bounds.push_back(instance.bounds);
+	}
+	// Moving instances only needs new bounds, new instances need a new tree
+	if (instance_bvh_.primitive_indices().size() == instances_.size() && !instance_bvh_.empty())
+	{
+		instance_bvh_.Refit(bounds);
+	}
+	else
+	{
+		instance_bvh_.Build(bounds);
+	}
+	instances_changed_ = false;
+}
+
+bool Raytracer::IntersectInstances(
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance,
+	InstanceHit& instance_hit) const
+{
+	if (instances_.empty())
+	{
 		return false;
 	}
-	// Return that the point is in the light
-	return true;
+	return instance_bvh_.Intersect(origin, direction, distance,
+		[&](std::uint32_t index, float& closest_distance)
+		{
+			const Instance& instance = instances_[index];
+			// The object space direction is normalized,
+			// so the distances are scaled by its length
+			maths::Vector3f object_direction = TransformDirection(instance.inverse_transform, direction);
+			const float scale = object_direction.Magnitude();
+			object_direction /= scale;
+			float object_distance = closest_distance * scale;
+			std::uint32_t primitive;
+			if (!models_[instance.model].Intersect(TransformPoint(instance.inverse_transform, origin),
+				object_direction, object_distance, primitive))
+			{
+				return false;
+			}
+			closest_distance = object_distance / scale;
+			instance_hit = { index, primitive };
+			return true;
+		});
+}
+
+bool Raytracer::OccludedByInstances(
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float max_distance) const
+{
+	if (instances_.empty())
+	{
+		return false;
+	}
+	return instance_bvh_.Occluded(origin, direction, max_distance, [&](std::uint32_t index)
+	{
+		const Instance& instance = instances_[index];
+		maths::Vector3f object_direction = TransformDirection(instance.inverse_transform, direction);
+		const float scale = object_direction.Magnitude();
+		object_direction /= scale;
+		return models_[instance.model].Occluded(TransformPoint(instance.inverse_transform, origin),
+			object_direction, max_distance * scale);
+	});
+}
+
+void Raytracer::ResolveInstanceHit(
+	const InstanceHit& instance_hit,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	HitInfos& hit_info) const
+{
+	const Instance& instance = instances_[instance_hit.instance];
+	const Model& model = models_[instance.model];
+	hit_info.hit_position = origin + direction * hit_info.distance;
+	if (instance_hit.primitive < model.spheres.size())
+	{
+		const maths::Vector3f object_position = TransformPoint(instance.inverse_transform, hit_info.hit_position);
+		hit_info.normal = TransformNormal(instance.inverse_transform,
+			object_position - model.spheres.center(instance_hit.primitive));
+		hit_info.material_index = model.spheres.material_index[instance_hit.primitive];
+		return;
+	}
+	hit_info.normal = TransformNormal(instance.inverse_transform,
+		model.triangles.normal(instance_hit.primitive - model.spheres.size()));
+	if (maths::Vector3f::Dot(hit_info.normal, direction) > 0.0f)
+	{
+		hit_info.normal = hit_info.normal * -1.0f;
+	}
+	hit_info.material_index = model.triangle_material_index;
+}
+
+bool Raytracer::IntersectPlanes(
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	float& distance,
+	std::uint32_t& plane_index) const
+{
+	bool has_hit = false;
+	for (std::uint32_t i = 0; i < planes_.size(); ++i)
+	{
+		if (IntersectPlane(planes_[i], origin, direction, distance))
+		{
+			plane_index = i;
+			has_hit = true;
+		}
+	}
+	return has_hit;
+}
+
+void Raytracer::ResolvePlaneHit(
+	std::uint32_t plane_index,
+	const maths::Vector3f& origin,
+	const maths::Vector3f& direction,
+	HitInfos& hit_info) const
+{
+	hit_info.hit_position = origin + direction * hit_info.distance;
+	hit_info.normal = planes_[plane_index].normal();
+	hit_info.material_index = planes_[plane_index].material_index();
+}
+
+void Raytracer::CullPrimitives()
+{
+	visible_primitives_.clear();
+	primary_rays_culled_ = acceleration_ == Acceleration::kBruteForce;
+	if (!primary_rays_culled_)
+	{
+		return;
+	}
+	// The primary rays start at the camera and stop at the same
+	// distance as in ObjectIntersect
+	maths::Frustum frustum = camera_.frustum(0.0f, 1000000.0f);
+	for (std::uint32_t i = 0; i < spheres_.size(); ++i)
+	{
+		if (frustum.contains(spheres_.bounds(i)))
+		{
+			visible_primitives_.push_back(i);
+		}
+	}
+	const std::uint32_t first_triangle = static_cast<std::uint32_t>(spheres_.size());
+	for (std::uint32_t i = 0; i < triangles_.triangle_count(); ++i)
+	{
+		if (frustum.contains(triangles_.bounds(i)))
+		{
+			visible_primitives_.push_back(first_triangle + i);
+		}
+	}
+}
+
+void Raytracer::BuildBvh()
+{
+	// The triangles are numbered after the spheres
+	std::vector<maths::AABB3> bounds;
+	bounds.reserve(PrimitiveCount());
+	for (std::size_t i = 0; i < spheres_.size(); ++i)
+	{
+		bounds.push_back(spheres_.bounds(i));
+	}
+	for (std::size_t i = 0; i < triangles_.triangle_count(); ++i)
+	{
+		bounds.push_back(triangles_.bounds(i));
+	}
+	bvh_.Build(bounds);
+	//The spheres of a leaf are then read one after the other
+	spheres_.Reorder(bvh_.RenumberPrimitives(spheres_.size()));
 }
 
 maths::Vector3f Raytracer::Reflect(
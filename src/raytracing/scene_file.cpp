@@ -0,0 +1,428 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include "raytracing/scene_file.h"
+#include "raytracing/text_parsing.h"
+
+namespace raytracing {
+
+static_assert(std::is_trivially_copyable_v<ScenePlane>);
+static_assert(std::is_trivially_copyable_v<BvhNode>);
+static_assert(std::is_trivially_copyable_v<SceneFileHeader>);
+
+namespace {
+
+constexpr std::uint64_t kSectionAlignment = 64;
+
+std::uint64_t AlignSection(std::uint64_t offset)
+{
+	return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+}
+
+std::size_t SectionElementSize(SceneSection section)
+{
+	switch (section)
+	{
+	case SceneSection::kSphereCenterX:
+	case SceneSection::kSphereCenterY:
+	case SceneSection::kSphereCenterZ:
+	case SceneSection::kSphereRadius:
+		return sizeof(float);
+	case SceneSection::kSphereMaterial:
+	case SceneSection::kBvhIndices:
+		return sizeof(std::uint32_t);
+	case SceneSection::kPlanes:
+		return sizeof(ScenePlane);
+	case SceneSection::kMaterials:
+		return sizeof(SceneMaterialRecord);
+	case SceneSection::kLights:
+		return sizeof(SceneLightRecord);
+	case SceneSection::kBvhNodes:
+		return sizeof(BvhNode);
+	default:
+		return 0;
+	}
+}
+
+std::uint64_t SectionElementCount(const SceneFileHeader& header, SceneSection section)
+{
+	switch (section)
+	{
+	case SceneSection::kSphereCenterX:
+	case SceneSection::kSphereCenterY:
+	case SceneSection::kSphereCenterZ:
+	case SceneSection::kSphereRadius:
+	case SceneSection::kSphereMaterial:
+		return header.sphere_count;
+	case SceneSection::kPlanes:
+		return header.plane_count;
+	case SceneSection::kMaterials:
+		return header.material_count;
+	case SceneSection::kLights:
+		return header.light_count;
+	case SceneSection::kBvhNodes:
+		return header.bvh_node_count;
+	case SceneSection::kBvhIndices:
+		return header.bvh_node_count == 0 ? 0 : header.sphere_count;
+	default:
+		return 0;
+	}
+}
+
+// Read count floats of the line into values
+bool ParseFloats(const char*& begin, const char* end, float* values, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (!ParseFloat(NextToken(begin, end), values[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Image sizes the frame buffer is allocated for
+bool IsValidImageSize(std::int64_t width, std::int64_t height)
+{
+	return width > 0 && height > 0
+		&& width <= SceneFileHeader::kMaxImageSize && height <= SceneFileHeader::kMaxImageSize;
+}
+
+// A light gives a positive finite intensity, and its falloff radius is
+// positive, infinite for a light that does not fade
+bool IsValidLight(float intensity, float falloff_radius)
+{
+	return std::isfinite(intensity) && intensity > 0.0f && falloff_radius > 0.0f;
+}
+
+}// namespace
+
+bool ParseScene(std::string_view text, SceneDescription& scene)
+{
+	scene = SceneDescription();
+	const char* begin = text.data();
+	const char* const end = text.data() + text.size();
+	while (begin != end)
+	{
+		const char* const line_end = LineEnd(begin, end);
+		const std::string_view keyword = NextToken(begin, line_end);
+		float values[6];
+		if (keyword == "image")
+		{
+			if (!ParseNumber(NextToken(begin, line_end), scene.width)
+				|| !ParseNumber(NextToken(begin, line_end), scene.height)
+				|| !IsValidImageSize(scene.width, scene.height))
+			{
+				return false;
+			}
+		}
+		else if (keyword == "bias")
+		{
+			if (!ParseNumber(NextToken(begin, line_end), scene.bias))
+			{
+				return false;
+			}
+		}
+		else if (keyword == "camera")
+		{
+			if (!ParseFloats(begin, line_end, values, 5))
+			{
+				return false;
+			}
+			maths::Matrix4f orientation = maths::Matrix4f::identity();
+			const std::string_view next = NextToken(begin, line_end);
+			if (!next.empty())
+			{
+				// The rotation rows follow the position, the matrix holds columns
+				begin = next.data();
+				float rotation[9];
+				if (!ParseFloats(begin, line_end, rotation, 9))
+				{
+					return false;
+				}
+				orientation = maths::Matrix4f(
+					maths::Vector4f(rotation[0], rotation[3], rotation[6], 0.0f),
+					maths::Vector4f(rotation[1], rotation[4], rotation[7], 0.0f),
+					maths::Vector4f(rotation[2], rotation[5], rotation[8], 0.0f),
+					maths::Vector4f(0.0f, 0.0f, 0.0f, 1.0f));
+			}
+			scene.camera = Camera(maths::Vector3f(values[2], values[3], values[4]),
+				orientation, maths::radian_t(values[0]), values[1]);
+		}
+		else if (keyword == "material")
+		{
+			if (!ParseFloats(begin, line_end, values, 4))
+			{
+				return false;
+			}
+			scene.materials.emplace_back(values[0], maths::Vector3f(values[1], values[2], values[3]));
+		}
+		else if (keyword == "sphere")
+		{
+			std::uint32_t material;
+			if (!ParseFloats(begin, line_end, values, 4)
+				|| !ParseNumber(NextToken(begin, line_end), material))
+			{
+				return false;
+			}
+			scene.spheres.push_back(maths::Vector3f(values[0], values[1], values[2]), values[3], material);
+		}
+		else if (keyword == "plane")
+		{
+			ScenePlane plane;
+			if (!ParseFloats(begin, line_end, values, 6)
+				|| !ParseNumber(NextToken(begin, line_end), plane.material_index))
+			{
+				return false;
+			}
+			plane.point = maths::Vector3f(values[0], values[1], values[2]);
+			plane.normal = maths::Vector3f(values[3], values[4], values[5]).Normalized();
+			scene.planes.push_back(plane);
+		}
+		else if (keyword == "light")
+		{
+			if (!ParseFloats(begin, line_end, values, 3))
+			{
+				return false;
+			}
+			PointLight light;
+			light.position = maths::Vector3f(values[0], values[1], values[2]);
+			const std::string_view intensity = NextToken(begin, line_end);
+			if (!intensity.empty() && !ParseFloat(intensity, light.intensity))
+			{
+				return false;
+			}
+			const std::string_view falloff_radius = NextToken(begin, line_end);
+			if ((!falloff_radius.empty() && !ParseFloat(falloff_radius, light.falloff_radius))
+				|| !IsValidLight(light.intensity, light.falloff_radius))
+			{
+				return false;
+			}
+			scene.lights.push_back(light);
+		}
+		else if (!keyword.empty() && keyword[0] != '#')
+		{
+			return false;
+		}
+
+		begin = line_end == end ? end : line_end + 1;
+	}
+
+	// The materials may be declared after the objects using them
+	const auto material_count = static_cast<std::uint32_t>(scene.materials.size());
+	const bool spheres_valid = std::all_of(scene.spheres.material_index.begin(), scene.spheres.material_index.end(),
+		[&](std::uint32_t index) { return index < material_count; });
+	const bool planes_valid = std::all_of(scene.planes.begin(), scene.planes.end(),
+		[&](const ScenePlane& plane) { return plane.material_index < material_count; });
+	return spheres_valid && planes_valid;
+}
+
+bool WriteSceneFile(const std::string& path, const SceneDescription& scene, bool with_bvh)
+{
+	Bvh bvh;
+	SphereArrays spheres = scene.spheres;
+	if (with_bvh && !scene.spheres.empty())
+	{
+		// Same hierarchy as the one the raytracer builds over its spheres
+		std::vector<maths::AABB3> bounds;
+		bounds.reserve(scene.spheres.size());
+		for (std::size_t i = 0; i < scene.spheres.size(); ++i)
+		{
+			bounds.push_back(scene.spheres.bounds(i));
+		}
+		bvh.Build(bounds);
+		spheres.Reorder(bvh.RenumberPrimitives(spheres.size()));
+	}
+
+	std::vector<SceneMaterialRecord> materials;
+	materials.reserve(scene.materials.size());
+	for (const Material& material : scene.materials)
+	{
+		const maths::Vector3f color = material.color();
+		materials.push_back({ { color.x, color.y, color.z }, material.reflexion_index() });
+	}
+	std::vector<SceneLightRecord> lights;
+	lights.reserve(scene.lights.size());
+	for (const PointLight& light : scene.lights)
+	{
+		lights.push_back({ { light.position.x, light.position.y, light.position.z },
+			light.intensity, light.falloff_radius });
+	}
+
+	SceneFileHeader header{};
+	std::memcpy(header.magic, SceneFileHeader::kMagic, sizeof(header.magic));
+	header.version = SceneFileHeader::kVersion;
+	header.width = static_cast<std::uint32_t>(scene.width);
+	header.height = static_cast<std::uint32_t>(scene.height);
+	header.bias = scene.bias;
+	const Camera& camera = scene.camera;
+	header.camera_position[0] = camera.position().x;
+	header.camera_position[1] = camera.position().y;
+	header.camera_position[2] = camera.position().z;
+	header.camera_fov = camera.fov().value();
+	header.camera_aspect = camera.aspect();
+	for (int column = 0; column < 4; ++column)
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			header.camera_orientation[4 * column + row] = camera.orientation()[column][row];
+		}
+	}
+	header.sphere_count = scene.spheres.size();
+	header.plane_count = scene.planes.size();
+	header.material_count = materials.size();
+	header.light_count = lights.size();
+	header.bvh_node_count = bvh.nodes().size();
+
+	const void* section_data[static_cast<std::size_t>(SceneSection::kCount)] = {
+		spheres.center_x.data(),
+		spheres.center_y.data(),
+		spheres.center_z.data(),
+		spheres.radius.data(),
+		spheres.material_index.data(),
+		scene.planes.data(),
+		materials.data(),
+		lights.data(),
+		bvh.nodes().data(),
+		bvh.primitive_indices().data() };
+	std::uint64_t offset = AlignSection(sizeof(SceneFileHeader));
+	for (std::size_t i = 0; i < static_cast<std::size_t>(SceneSection::kCount); ++i)
+	{
+		const auto section = static_cast<SceneSection>(i);
+		header.section_offsets[i] = offset;
+		offset = AlignSection(offset + SectionElementCount(header, section) * SectionElementSize(section));
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+	const char padding[kSectionAlignment] = {};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	std::uint64_t written = sizeof(header);
+	for (std::size_t i = 0; i < static_cast<std::size_t>(SceneSection::kCount); ++i)
+	{
+		const auto section = static_cast<SceneSection>(i);
+		file.write(padding, static_cast<std::streamsize>(header.section_offsets[i] - written));
+		const std::uint64_t size = SectionElementCount(header, section) * SectionElementSize(section);
+		file.write(static_cast<const char*>(section_data[i]), static_cast<std::streamsize>(size));
+		written = header.section_offsets[i] + size;
+	}
+	return static_cast<bool>(file);
+}
+
+bool ConvertSceneFile(const std::string& text_path, const std::string& binary_path)
+{
+	MappedFile text;
+	SceneDescription scene;
+	return text.Open(text_path)
+		&& ParseScene(text.view(), scene)
+		&& WriteSceneFile(binary_path, scene);
+}
+
+bool SceneFile::Open(const std::string& path)
+{
+	Close();
+	// The spans of the sections can be read in any order, such as the
+	// hierarchy in the order of a traversal
+	if (!file_.Open(path, MappedFile::Access::kRandom) || file_.size() < sizeof(SceneFileHeader))
+	{
+		Close();
+		return false;
+	}
+	// The mapping starts on a page, the header and the sections are aligned
+	const auto* header = reinterpret_cast<const SceneFileHeader*>(file_.data());
+	if (std::memcmp(header->magic, SceneFileHeader::kMagic, sizeof(header->magic)) != 0
+		|| header->version != SceneFileHeader::kVersion)
+	{
+		Close();
+		return false;
+	}
+	for (std::size_t i = 0; i < static_cast<std::size_t>(SceneSection::kCount); ++i)
+	{
+		const auto section = static_cast<SceneSection>(i);
+		const std::uint64_t offset = header->section_offsets[i];
+		const std::uint64_t count = SectionElementCount(*header, section);
+		const std::uint64_t available = offset <= file_.size() ? file_.size() - offset : 0;
+		if (offset % kSectionAlignment != 0 || count > available / SectionElementSize(section))
+		{
+			Close();
+			return false;
+		}
+	}
+	header_ = header;
+
+	// Every index read from the file is checked before it is followed, and
+	// every value sizing an allocation or dividing the light
+	const std::size_t material_count = materials().size();
+	const auto valid_material = [material_count](std::uint32_t index) { return index < material_count; };
+	const bool valid = IsValidImageSize(header->width, header->height)
+		&& std::ranges::all_of(lights(), [](const SceneLightRecord& light)
+			{ return IsValidLight(light.intensity, light.falloff_radius); })
+		&& std::ranges::all_of(sphere_material_index(), valid_material)
+		&& std::ranges::all_of(planes(), [&](const ScenePlane& plane) { return valid_material(plane.material_index); })
+		&& Bvh::IsValid(bvh_nodes(), bvh_primitive_indices(), sphere_radius().size());
+	if (!valid)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void SceneFile::Close()
+{
+	file_.Close();
+	header_ = nullptr;
+}
+
+Camera SceneFile::camera() const
+{
+	const float* orientation = header_->camera_orientation;
+	return Camera(
+		maths::Vector3f(header_->camera_position[0], header_->camera_position[1], header_->camera_position[2]),
+		maths::Matrix4f(
+			maths::Vector4f(orientation[0], orientation[1], orientation[2], orientation[3]),
+			maths::Vector4f(orientation[4], orientation[5], orientation[6], orientation[7]),
+			maths::Vector4f(orientation[8], orientation[9], orientation[10], orientation[11]),
+			maths::Vector4f(orientation[12], orientation[13], orientation[14], orientation[15])),
+		maths::radian_t(header_->camera_fov),
+		header_->camera_aspect);
+}
+
+std::size_t SceneFile::SectionCount(SceneSection section) const
+{
+	return static_cast<std::size_t>(SectionElementCount(*header_, section));
+}
+
+}// namespace raytracing
@@ -0,0 +1,142 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <charconv>
+
+#include "raytracing/mapped_file.h"
+#include "raytracing/text_parsing.h"
+#include "raytracing/triangle_mesh.h"
+
+namespace raytracing {
+
+namespace {
+
+// Read the vertex index of a face corner written as v, v/vt, v//vn or v/vt/vn,
+// negative indices are relative to the last vertex read
+bool ParseVertexIndex(std::string_view token, std::size_t vertex_count, std::uint32_t& index)
+{
+	long long value = 0;
+	const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+	if (error != std::errc() || (end != token.data() + token.size() && *end != '/'))
+	{
+		return false;
+	}
+	if (value < 0)
+	{
+		value += static_cast<long long>(vertex_count);
+	}
+	else
+	{
+		--value;
+	}
+	if (value < 0 || value >= static_cast<long long>(vertex_count))
+	{
+		return false;
+	}
+	index = static_cast<std::uint32_t>(value);
+	return true;
+}
+
+}// namespace
+
+std::size_t TriangleMesh::Append(const TriangleMesh& mesh)
+{
+	const std::size_t first_triangle = triangle_count();
+	const auto vertex_offset = static_cast<std::uint32_t>(vertices.size());
+	vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+	indices.reserve(indices.size() + mesh.indices.size());
+	for (const std::uint32_t index : mesh.indices)
+	{
+		indices.push_back(index + vertex_offset);
+	}
+	return first_triangle;
+}
+
+bool ParseObj(std::string_view text, TriangleMesh& mesh)
+{
+	mesh.clear();
+	const char* begin = text.data();
+	const char* const end = text.data() + text.size();
+	while (begin != end)
+	{
+		const char* const line_end = LineEnd(begin, end);
+
+		const std::string_view keyword = NextToken(begin, line_end);
+		if (keyword == "v")
+		{
+			maths::Vector3f vertex;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (!ParseFloat(NextToken(begin, line_end), vertex[axis]))
+				{
+					return false;
+				}
+			}
+			mesh.vertices.push_back(vertex);
+		}
+		else if (keyword == "f")
+		{
+			// Split the polygon in a fan of triangles around its first vertex
+			std::uint32_t first;
+			std::uint32_t previous;
+			if (!ParseVertexIndex(NextToken(begin, line_end), mesh.vertices.size(), first)
+				|| !ParseVertexIndex(NextToken(begin, line_end), mesh.vertices.size(), previous))
+			{
+				return false;
+			}
+			int corner_count = 2;
+			for (std::string_view token = NextToken(begin, line_end); !token.empty();
+				token = NextToken(begin, line_end))
+			{
+				std::uint32_t current;
+				if (!ParseVertexIndex(token, mesh.vertices.size(), current))
+				{
+					return false;
+				}
+				mesh.indices.insert(mesh.indices.end(), { first, previous, current });
+				previous = current;
+				++corner_count;
+			}
+			if (corner_count < 3)
+			{
+				return false;
+			}
+		}
+
+		begin = line_end == end ? end : line_end + 1;
+	}
+	return true;
+}
+
+bool LoadObj(const std::string& path, TriangleMesh& mesh)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		return false;
+	}
+	return ParseObj(file.view(), mesh);
+}
+
+}// namespace raytracing
@@ -0,0 +1,174 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <algorithm>
+
+#include "thread_pool.h"
+
+namespace threading {
+
+ThreadPool::ThreadPool(std::size_t thread_count)
+{
+	if (thread_count == 0)
+	{
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	}
+	for (std::size_t i = 0; i < thread_count; ++i)
+	{
+		queues_.push_back(std::make_unique<TaskQueue>());
+	}
+	// Queue 0 belongs to the thread calling ParallelFor
+	for (std::size_t i = 1; i < thread_count; ++i)
+	{
+		workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	work_condition_.notify_all();
+	for (std::thread& worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& task)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (workers_.empty())
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			task(i);
+		}
+		return;
+	}
+
+	task_ = &task;
+	remaining_tasks_ = count;
+	// Give each queue a contiguous block, neighbouring tasks tend to share data
+	const std::size_t queue_count = queues_.size();
+	for (std::size_t queue_index = 0; queue_index < queue_count; ++queue_index)
+	{
+		const std::size_t begin = count * queue_index / queue_count;
+		const std::size_t end = count * (queue_index + 1) / queue_count;
+		std::lock_guard<std::mutex> lock(queues_[queue_index]->mutex);
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			queues_[queue_index]->tasks.push_back(i);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		++generation_;
+	}
+	work_condition_.notify_all();
+
+	RunTasks(0);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_condition_.wait(lock, [this]() { return remaining_tasks_ == 0; });
+	task_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop(std::size_t queue_index)
+{
+	std::size_t seen_generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			work_condition_.wait(lock, [&]() { return stop_ || generation_ != seen_generation; });
+			if (stop_)
+			{
+				return;
+			}
+			seen_generation = generation_;
+		}
+		RunTasks(queue_index);
+	}
+}
+
+void ThreadPool::RunTasks(std::size_t queue_index)
+{
+	while (true)
+	{
+		std::optional<std::size_t> task_index = PopTask(queue_index);
+		if (!task_index)
+		{
+			task_index = StealTask(queue_index);
+		}
+		if (!task_index)
+		{
+			return;
+		}
+		(*task_)(*task_index);
+		if (--remaining_tasks_ == 0)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			done_condition_.notify_all();
+		}
+	}
+}
+
+std::optional<std::size_t> ThreadPool::PopTask(std::size_t queue_index)
+{
+	TaskQueue& queue = *queues_[queue_index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty())
+	{
+		return std::nullopt;
+	}
+	const std::size_t task_index = queue.tasks.front();
+	queue.tasks.pop_front();
+	return task_index;
+}
+
+std::optional<std::size_t> ThreadPool::StealTask(std::size_t queue_index)
+{
+	// Steal from the back, far from where the owner is working
+	const std::size_t queue_count = queues_.size();
+	for (std::size_t offset = 1; offset < queue_count; ++offset)
+	{
+		TaskQueue& queue = *queues_[(queue_index + offset) % queue_count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty())
+		{
+			const std::size_t task_index = queue.tasks.back();
+			queue.tasks.pop_back();
+			return task_index;
+		}
+	}
+	return std::nullopt;
+}
+
+}// namespace threading
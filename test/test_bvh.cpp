@@ -0,0 +1,221 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "raytracing/bvh.h"
+#include "maths/ray3.h"
+
+namespace raytracing {
+
+// Test that every primitive is referenced by exactly one leaf
+// and that each leaf bounds contain its primitives
+TEST(Raytracing, Bvh_Build)
+{
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> radius(0.5f, 3.0f);
+
+	std::vector<maths::Sphere> spheres;
+	std::vector<maths::AABB3> bounds;
+	for (int i = 0; i < 1000; ++i)
+	{
+		spheres.emplace_back(radius(generator),
+			maths::Vector3f(position(generator), position(generator), position(generator)));
+		bounds.push_back(spheres.back().bounds());
+	}
+
+	Bvh bvh;
+	bvh.Build(bounds);
+	ASSERT_FALSE(bvh.empty());
+
+	std::vector<int> references(spheres.size(), 0);
+	for (const BvhNode& node : bvh.nodes())
+	{
+		if (!node.IsLeaf())
+		{
+			continue;
+		}
+		for (std::uint32_t i = 0; i < node.primitive_count; ++i)
+		{
+			const std::uint32_t index = bvh.primitive_indices()[node.left_first + i];
+			references[index]++;
+			EXPECT_LE(node.bounds_min.x, bounds[index].bottom_left().x);
+			EXPECT_LE(node.bounds_min.y, bounds[index].bottom_left().y);
+			EXPECT_LE(node.bounds_min.z, bounds[index].bottom_left().z);
+			EXPECT_GE(node.bounds_max.x, bounds[index].top_right().x);
+			EXPECT_GE(node.bounds_max.y, bounds[index].top_right().y);
+			EXPECT_GE(node.bounds_max.z, bounds[index].top_right().z);
+		}
+	}
+	for (int count : references)
+	{
+		EXPECT_EQ(count, 1);
+	}
+}
+
+// Test that the traversal finds the same closest sphere as a brute force loop
+TEST(Raytracing, Bvh_ClosestHit)
+{
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+	std::vector<maths::Sphere> spheres;
+	std::vector<maths::AABB3> bounds;
+	for (int i = 0; i < 500; ++i)
+	{
+		spheres.emplace_back(1.0f,
+			maths::Vector3f(position(generator), position(generator), position(generator)));
+		bounds.push_back(spheres.back().bounds());
+	}
+	Bvh bvh;
+	bvh.Build(bounds);
+
+	for (int i = 0; i < 200; ++i)
+	{
+		maths::Ray3 ray(maths::Vector3f(0.0f, 0.0f, 0.0f),
+			maths::Vector3f(direction(generator), direction(generator), direction(generator)).Normalized());
+		auto intersect = [&](std::uint32_t index, float& distance)
+		{
+			maths::Vector3f hit_position;
+			float hit_distance;
+			if (ray.IntersectSphere(spheres[index], hit_position, hit_distance) && hit_distance < distance)
+			{
+				distance = hit_distance;
+				return true;
+			}
+			return false;
+		};
+
+		float expected_distance = 1000000.0f;
+		for (std::uint32_t j = 0; j < spheres.size(); ++j)
+		{
+			intersect(j, expected_distance);
+		}
+		float distance = 1000000.0f;
+		bvh.Intersect(ray.origin(), ray.direction(), distance, intersect);
+
+		EXPECT_EQ(distance, expected_distance);
+	}
+}
+
+// Test that a hierarchy read from outside is refused when following it
+// would leave its arrays, loop or overflow the traversal stack
+TEST(Raytracing, Bvh_IsValid)
+{
+	std::vector<maths::AABB3> bounds;
+	for (int i = 0; i < 40; ++i)
+	{
+		bounds.push_back(maths::AABB3(maths::Vector3f(2.0f * i, 0.0f, 0.0f), maths::Vector3f(2.0f * i + 1.0f, 1.0f, 1.0f)));
+	}
+	Bvh bvh;
+	bvh.Build(bounds);
+	std::vector<BvhNode> nodes = bvh.nodes();
+	const std::vector<std::uint32_t> indices = bvh.primitive_indices();
+	ASSERT_FALSE(nodes[0].IsLeaf());
+	EXPECT_TRUE(Bvh::IsValid(nodes, indices, bounds.size()));
+	EXPECT_FALSE(Bvh::IsValid(nodes, indices, bounds.size() - 1));
+	EXPECT_TRUE(Bvh::IsValid({}, {}, 0));
+
+	//The root pointing to itself
+	nodes[0].left_first = 0;
+	EXPECT_FALSE(Bvh::IsValid(nodes, indices, bounds.size()));
+
+	//A chain of inner nodes whose right child is a leaf, the hierarchy is
+	//refused once it is deeper than the traversal stack
+	auto chain = [](std::uint32_t depth)
+	{
+		std::vector<BvhNode> nodes(1);
+		for (std::uint32_t i = 0; i < depth; ++i)
+		{
+			const std::uint32_t parent = i == 0 ? 0 : static_cast<std::uint32_t>(nodes.size() - 2);
+			nodes[parent].left_first = static_cast<std::uint32_t>(nodes.size());
+			nodes.emplace_back();
+			nodes.emplace_back().primitive_count = 1;
+		}
+		nodes[nodes.size() - 2].primitive_count = 1;
+		return nodes;
+	};
+	const std::vector<std::uint32_t> one_index{ 0 };
+	EXPECT_TRUE(Bvh::IsValid(chain(20), one_index, 1));
+	EXPECT_FALSE(Bvh::IsValid(chain(70), one_index, 1));
+
+	//Both nodes of each level pointing at the same pair of children, the
+	//62 levels would make 2^62 paths from the root to the last leaves
+	std::vector<BvhNode> shared(1 + 2 * 62);
+	shared[0].left_first = 1;
+	for (std::uint32_t first = 3; first < shared.size(); first += 2)
+	{
+		shared[first - 2].left_first = first;
+		shared[first - 1].left_first = first;
+	}
+	shared[shared.size() - 2].primitive_count = 1;
+	shared[shared.size() - 1].primitive_count = 1;
+	EXPECT_FALSE(Bvh::IsValid(shared, one_index, 1));
+	//A node left out of the tree
+	std::vector<BvhNode> unreached = chain(3);
+	unreached.emplace_back().primitive_count = 1;
+	EXPECT_FALSE(Bvh::IsValid(unreached, one_index, 1));
+}
+
+// Test that the renumbered primitives follow the leaves, the ones
+// past the count keeping their index
+TEST(Raytracing, Bvh_RenumberPrimitives)
+{
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::vector<maths::AABB3> bounds;
+	for (int i = 0; i < 200; ++i)
+	{
+		const maths::Vector3f center(position(generator), position(generator), position(generator));
+		bounds.push_back(maths::AABB3(center - maths::Vector3f(1.0f, 1.0f, 1.0f), center + maths::Vector3f(1.0f, 1.0f, 1.0f)));
+	}
+	Bvh bvh;
+	bvh.Build(bounds);
+	const std::vector<std::uint32_t> before = bvh.primitive_indices();
+	const std::vector<std::uint32_t> previous = bvh.RenumberPrimitives(150);
+	ASSERT_EQ(previous.size(), 150u);
+
+	std::uint32_t next = 0;
+	for (std::size_t i = 0; i < before.size(); ++i)
+	{
+		const std::uint32_t index = bvh.primitive_indices()[i];
+		if (before[i] < 150)
+		{
+			EXPECT_EQ(index, next);
+			EXPECT_EQ(previous[next], before[i]);
+			++next;
+		}
+		else
+		{
+			EXPECT_EQ(index, before[i]);
+		}
+	}
+	EXPECT_TRUE(Bvh::IsValid(bvh.nodes(), bvh.primitive_indices(), bounds.size()));
+}
+
+}// namespace raytracing
@@ -0,0 +1,132 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "raytracing/camera.h"
+#include "raytracing/ray_tracer.h"
+
+namespace raytracing {
+
+// Test that the default camera gives the directions of a pinhole
+// at the origin looking down -Z
+TEST(Camera, RayDirection)
+{
+	const int width = 40;
+	const int height = 20;
+	const float fov = 1.2f;
+	Camera camera(maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Matrix4f::identity(), maths::radian_t(fov), 0.0f);
+	camera.Prepare(width, height);
+
+	for (const float x : { 0.0f, 3.5f, 20.0f, 39.5f })
+	{
+		for (const float y : { 0.0f, 10.0f, 17.25f })
+		{
+			const maths::Vector3f expected = maths::Vector3f(
+				x - width / 2.0f, height / 2.0f - y, -height / (2.0f * std::tan(fov / 2.0f))).Normalized();
+			const maths::Vector3f direction = camera.RayDirection(x, y);
+			EXPECT_NEAR(direction.x, expected.x, 1e-5f);
+			EXPECT_NEAR(direction.y, expected.y, 1e-5f);
+			EXPECT_NEAR(direction.z, expected.z, 1e-5f);
+		}
+	}
+
+	//A quarter turn around Y looks down -X, the right going to -Z
+	const maths::Matrix4f turn(
+		maths::Vector4f(0.0f, 0.0f, -1.0f, 0.0f),
+		maths::Vector4f(0.0f, 1.0f, 0.0f, 0.0f),
+		maths::Vector4f(1.0f, 0.0f, 0.0f, 0.0f),
+		maths::Vector4f(0.0f, 0.0f, 0.0f, 1.0f));
+	camera.set_orientation(turn);
+	camera.Prepare(width, height);
+	const maths::Vector3f center = camera.RayDirection(20.0f, 10.0f);
+	EXPECT_NEAR(center.x, -1.0f, 1e-5f);
+	EXPECT_NEAR(center.z, 0.0f, 1e-5f);
+	EXPECT_LT(camera.RayDirection(39.0f, 10.0f).z, 0.0f);
+}
+
+// Test that the frustum of the camera only keeps what the image shows
+TEST(Camera, Frustum_Culling)
+{
+	Camera camera(maths::Vector3f(0.0f, 0.0f, 5.0f), maths::Matrix4f::identity(), maths::radian_t(1.0f), 2.0f);
+	camera.Prepare(200, 100);
+	maths::Frustum frustum = camera.frustum(0.1f, 100.0f);
+
+	EXPECT_TRUE(frustum.contains(maths::Vector3f(0.0f, 0.0f, -10.0f)));
+	EXPECT_FALSE(frustum.contains(maths::Vector3f(0.0f, 0.0f, 10.0f)));
+	EXPECT_FALSE(frustum.contains(maths::Vector3f(0.0f, 0.0f, -200.0f)));
+	//tan(0.5) is about 0.55, the image is twice wider than high
+	EXPECT_TRUE(frustum.contains(maths::Vector3f(9.0f, 0.0f, -5.0f)));
+	EXPECT_FALSE(frustum.contains(maths::Vector3f(0.0f, 9.0f, -5.0f)));
+	EXPECT_FALSE(frustum.contains(maths::Vector3f(-12.0f, 0.0f, -5.0f)));
+
+	//A sphere crossing a side is kept, one fully outside is culled
+	EXPECT_TRUE(frustum.contains(maths::Sphere(1.0f, maths::Vector3f(0.0f, 6.0f, -5.0f))));
+	EXPECT_FALSE(frustum.contains(maths::Sphere(1.0f, maths::Vector3f(0.0f, 8.0f, -5.0f))));
+	EXPECT_FALSE(frustum.contains(maths::Sphere(1.0f, maths::Vector3f(20.0f, 0.0f, 0.0f))));
+}
+
+// Test that moving the camera renders like moving the scene the other way
+TEST(Camera, Raytracer_MovedCamera)
+{
+	const int width = 30;
+	const int height = 20;
+	maths::Sphere sphere(4.0f, maths::Vector3f(1.0f, 0.0f, -16.0f));
+	std::vector<Material> materials{ Material(0.0f, maths::Vector3f(255.0f, 0.0f, 0.0f)) };
+	PointLight light;
+
+	Raytracer reference;
+	reference.SetScene(std::vector<maths::Sphere>{ sphere }, std::vector<maths::Plane>(), materials,
+		light, height, width, 1.0f, 1e-4);
+	reference.Render();
+
+	const maths::Vector3f offset(3.0f, -2.0f, 5.0f);
+	maths::Sphere moved_sphere(4.0f, sphere.center() + offset);
+	PointLight moved_light = light;
+	moved_light.position = light.position + offset;
+
+	Raytracer moved;
+	moved.SetScene(std::vector<maths::Sphere>{ moved_sphere }, std::vector<maths::Plane>(), materials,
+		moved_light, height, width, 1.0f, 1e-4);
+	Camera camera = moved.camera();
+	camera.set_position(offset);
+	moved.set_camera(camera);
+	moved.Render();
+
+	int sphere_pixels = 0;
+	for (std::size_t i = 0; i < reference.frameBuffer().size(); ++i)
+	{
+		const maths::Vector3f& expected = reference.frameBuffer()[i];
+		const maths::Vector3f& tested = moved.frameBuffer()[i];
+		EXPECT_NEAR(expected.x, tested.x, 0.5f);
+		EXPECT_NEAR(expected.y, tested.y, 0.5f);
+		EXPECT_NEAR(expected.z, tested.z, 0.5f);
+		sphere_pixels += expected.z == 0.0f ? 1 : 0;
+	}
+	EXPECT_GT(sphere_pixels, 0);
+}
+
+}// namespace raytracing
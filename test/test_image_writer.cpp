@@ -0,0 +1,94 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "raytracing/image_writer.h"
+
+namespace raytracing {
+
+std::vector<char> ReadFile(const std::filesystem::path& path)
+{
+	std::ifstream ifs(path, std::ios::in | std::ios::binary);
+	return { std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+}
+
+// Test that the components are clamped to [0, 255] and truncated
+TEST(ImageWriter, ConvertToRgb8)
+{
+	const std::vector<maths::Vector3f> colors{
+		maths::Vector3f(-10.0f, 0.0f, 12.7f),
+		maths::Vector3f(254.9f, 255.0f, 1000.0f) };
+	std::vector<std::uint8_t> rgb;
+	ConvertToRgb8(colors, rgb);
+
+	const std::vector<std::uint8_t> expected{ 0, 0, 12, 254, 255, 255 };
+	EXPECT_EQ(rgb, expected);
+}
+
+// Test that the .ppm file holds the header followed by the pixels
+TEST(ImageWriter, WritePpm)
+{
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "test_write_ppm.ppm";
+	const std::vector<std::uint8_t> rgb{ 1, 2, 3, 4, 5, 6 };
+	ASSERT_TRUE(WritePpm(path.string(), 2, 1, rgb));
+
+	const std::string header = "P6\n2 1\n255\n";
+	std::vector<char> expected(header.begin(), header.end());
+	expected.insert(expected.end(), rgb.begin(), rgb.end());
+	EXPECT_EQ(ReadFile(path), expected);
+	std::filesystem::remove(path);
+}
+
+// Test that the queued images are all written once flushed
+TEST(ImageWriter, AsyncImageWriter)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path();
+	AsyncImageWriter writer;
+	for (int i = 0; i < 3; ++i)
+	{
+		std::vector<std::uint8_t> rgb(3 * 4, static_cast<std::uint8_t>(i));
+		writer.Write((directory / ("test_async_" + std::to_string(i) + ".ppm")).string(), 2, 2, std::move(rgb));
+	}
+	EXPECT_TRUE(writer.Flush());
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const std::filesystem::path path = directory / ("test_async_" + std::to_string(i) + ".ppm");
+		const std::vector<char> content = ReadFile(path);
+		ASSERT_EQ(content.size(), std::string("P6\n2 2\n255\n").size() + 12);
+		EXPECT_EQ(content.back(), static_cast<char>(i));
+		std::filesystem::remove(path);
+	}
+
+	//A path that cannot be opened is reported by the flush
+	writer.Write((directory / "missing_directory" / "image.ppm").string(), 1, 1, std::vector<std::uint8_t>(3));
+	EXPECT_FALSE(writer.Flush());
+}
+
+}// namespace raytracing
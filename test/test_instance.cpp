@@ -0,0 +1,136 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include "raytracing/instance.h"
+
+namespace raytracing {
+
+namespace {
+
+maths::Matrix4f ScaleAndTranslate(float scale, const maths::Vector3f& translation)
+{
+	return maths::Matrix4f(
+		maths::Vector4f(scale, 0.0f, 0.0f, 0.0f),
+		maths::Vector4f(0.0f, scale, 0.0f, 0.0f),
+		maths::Vector4f(0.0f, 0.0f, scale, 0.0f),
+		maths::Vector4f(translation.x, translation.y, translation.z, 1.0f));
+}
+
+}// namespace
+
+// Test that the inverse brings the transformed points back
+TEST(Instance, AffineInverse)
+{
+	const maths::Matrix4f transform(
+		maths::Vector4f(0.0f, 1.0f, 0.0f, 0.0f),
+		maths::Vector4f(-2.0f, 0.0f, 0.0f, 0.0f),
+		maths::Vector4f(0.0f, 0.5f, 3.0f, 0.0f),
+		maths::Vector4f(1.0f, -3.0f, 7.0f, 1.0f));
+	const maths::Matrix4f inverse = AffineInverse(transform);
+	const maths::Vector3f point(1.0f, 2.0f, 3.0f);
+	const maths::Vector3f back = TransformPoint(inverse, TransformPoint(transform, point));
+	EXPECT_NEAR(back.x, point.x, 1e-5f);
+	EXPECT_NEAR(back.y, point.y, 1e-5f);
+	EXPECT_NEAR(back.z, point.z, 1e-5f);
+
+	//The translation given by Matrix4f::translationMatrix is used as is
+	const maths::Vector3f translated = TransformPoint(
+		maths::Matrix4f::translationMatrix(maths::Vector3f(1.0f, 2.0f, 3.0f)), point);
+	EXPECT_EQ(translated, maths::Vector3f(2.0f, 4.0f, 6.0f));
+}
+
+// Test that the helpers agree with Matrix4f on a rotation that is not
+// its own transpose, the columns being the images of the axes
+TEST(Instance, ColumnConvention)
+{
+	//A quarter turn around Z sends X to Y, then a translation
+	const maths::Matrix4f transform(
+		maths::Vector4f(0.0f, 1.0f, 0.0f, 0.0f),
+		maths::Vector4f(-1.0f, 0.0f, 0.0f, 0.0f),
+		maths::Vector4f(0.0f, 0.0f, 1.0f, 0.0f),
+		maths::Vector4f(5.0f, 6.0f, 7.0f, 1.0f));
+	const maths::Vector3f point(1.0f, 2.0f, 3.0f);
+	const maths::Vector4f expected = transform * maths::Vector4f(point.x, point.y, point.z, 1.0f);
+	const maths::Vector3f moved = TransformPoint(transform, point);
+	EXPECT_FLOAT_EQ(moved.x, expected.x);
+	EXPECT_FLOAT_EQ(moved.y, expected.y);
+	EXPECT_FLOAT_EQ(moved.z, expected.z);
+	EXPECT_EQ(moved, maths::Vector3f(3.0f, 7.0f, 10.0f));
+	EXPECT_EQ(TransformDirection(transform, maths::Vector3f(1.0f, 0.0f, 0.0f)), maths::Vector3f(0.0f, 1.0f, 0.0f));
+
+	const maths::Matrix4f inverse = AffineInverse(transform);
+	const maths::Vector3f back = TransformPoint(inverse, moved);
+	EXPECT_NEAR(back.x, point.x, 1e-5f);
+	EXPECT_NEAR(back.y, point.y, 1e-5f);
+	EXPECT_NEAR(back.z, point.z, 1e-5f);
+
+	//The normal of the plane x = 1 turns with the rotation
+	const maths::Vector3f normal = TransformNormal(inverse, maths::Vector3f(1.0f, 0.0f, 0.0f));
+	EXPECT_NEAR(normal.x, 0.0f, 1e-5f);
+	EXPECT_NEAR(normal.y, 1.0f, 1e-5f);
+	EXPECT_NEAR(normal.z, 0.0f, 1e-5f);
+}
+
+TEST(Instance, TransformBounds)
+{
+	const maths::AABB3 bounds(maths::Vector3f(-1.0f, -1.0f, -1.0f), maths::Vector3f(1.0f, 2.0f, 1.0f));
+	const maths::AABB3 transformed = TransformBounds(ScaleAndTranslate(-2.0f, maths::Vector3f(0.0f, 0.0f, -10.0f)), bounds);
+	EXPECT_EQ(transformed.bottom_left(), maths::Vector3f(-2.0f, -4.0f, -12.0f));
+	EXPECT_EQ(transformed.top_right(), maths::Vector3f(2.0f, 2.0f, -8.0f));
+}
+
+// Test that a model is hit in its own space, and that a moved
+// instance only needs a refit of the bounds
+TEST(Instance, ModelIntersect)
+{
+	Model model;
+	model.spheres.push_back(maths::Vector3f(0.0f, 0.0f, 0.0f), 1.0f, 0);
+	model.Build();
+	Instance instance;
+	instance.SetTransform(ScaleAndTranslate(2.0f, maths::Vector3f(0.0f, 0.0f, -10.0f)), model);
+	EXPECT_EQ(instance.bounds.bottom_left(), maths::Vector3f(-2.0f, -2.0f, -12.0f));
+
+	float distance = 100.0f;
+	std::uint32_t primitive;
+	const maths::Vector3f origin = TransformPoint(instance.inverse_transform, maths::Vector3f(0.0f, 0.0f, 0.0f));
+	ASSERT_TRUE(model.Intersect(origin, maths::Vector3f(0.0f, 0.0f, -1.0f), distance, primitive));
+	EXPECT_EQ(primitive, 0u);
+	//The distance is in object space
+	EXPECT_FLOAT_EQ(distance, 4.0f);
+	EXPECT_TRUE(model.Occluded(origin, maths::Vector3f(0.0f, 0.0f, -1.0f), 5.0f));
+	EXPECT_FALSE(model.Occluded(origin, maths::Vector3f(0.0f, 0.0f, -1.0f), 3.0f));
+
+	std::vector<maths::AABB3> bounds{ maths::AABB3(maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Vector3f(1.0f, 1.0f, 1.0f)),
+		maths::AABB3(maths::Vector3f(5.0f, 0.0f, 0.0f), maths::Vector3f(6.0f, 1.0f, 1.0f)) };
+	Bvh bvh;
+	bvh.Build(bounds);
+	bounds[1] = maths::AABB3(maths::Vector3f(-6.0f, 0.0f, 0.0f), maths::Vector3f(-5.0f, 3.0f, 1.0f));
+	bvh.Refit(bounds);
+	EXPECT_EQ(bvh.nodes()[0].bounds_min, maths::Vector3f(-6.0f, 0.0f, 0.0f));
+	EXPECT_EQ(bvh.nodes()[0].bounds_max, maths::Vector3f(1.0f, 3.0f, 1.0f));
+}
+
+}// namespace raytracing
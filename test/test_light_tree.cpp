@@ -0,0 +1,94 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "raytracing/light_tree.h"
+
+namespace raytracing {
+
+// Test that without falloff each light is picked with a probability
+// following its share of the total intensity
+TEST(LightTree, Sample_FollowsIntensity)
+{
+	std::vector<PointLight> lights;
+	float total_intensity = 0.0f;
+	for (int i = 0; i < 100; ++i)
+	{
+		PointLight light;
+		light.position = maths::Vector3f(static_cast<float>(i % 10), static_cast<float>(i / 10), 0.0f);
+		light.intensity = 1.0f + i;
+		total_intensity += light.intensity;
+		lights.push_back(light);
+	}
+	LightTree light_tree;
+	light_tree.Build(lights);
+	ASSERT_EQ(light_tree.size(), lights.size());
+
+	std::vector<bool> picked(lights.size(), false);
+	for (int i = 0; i < 10000; ++i)
+	{
+		float pdf;
+		const std::uint32_t light_index = light_tree.Sample(maths::Vector3f(5.0f, 5.0f, 5.0f), (i + 0.5f) / 10000.0f, pdf);
+		ASSERT_LT(light_index, lights.size());
+		EXPECT_NEAR(pdf, lights[light_index].intensity / total_intensity, 1e-5f);
+		picked[light_index] = true;
+	}
+	for (std::size_t i = 0; i < lights.size(); ++i)
+	{
+		EXPECT_TRUE(picked[i]);
+	}
+}
+
+// Test that lights fading with distance are rarely picked far away from them
+TEST(LightTree, Sample_FavorsCloseLights)
+{
+	std::vector<PointLight> lights;
+	for (int i = 0; i < 64; ++i)
+	{
+		PointLight light;
+		light.position = maths::Vector3f(i < 32 ? -100.0f : 100.0f, static_cast<float>(i % 32), 0.0f);
+		light.falloff_radius = 1.0f;
+		lights.push_back(light);
+	}
+	LightTree light_tree;
+	light_tree.Build(lights);
+
+	int close_count = 0;
+	for (int i = 0; i < 100; ++i)
+	{
+		float pdf;
+		const std::uint32_t light_index = light_tree.Sample(maths::Vector3f(100.0f, 16.0f, 0.0f), (i + 0.5f) / 100.0f, pdf);
+		EXPECT_GT(pdf, 0.0f);
+		if (lights[light_index].position.x > 0.0f)
+		{
+			++close_count;
+		}
+	}
+	EXPECT_GE(close_count, 99);
+}
+
+}// namespace raytracing
@@ -460,19 +460,26 @@ TEST(Maths, Matrix4f_TranslationMatrix) {
 	EXPECT_EQ(a[0][0], 1);
 	EXPECT_EQ(a[0][1], 0);
 	EXPECT_EQ(a[0][2], 0);
-	EXPECT_EQ(a[0][3], 1);
+	EXPECT_EQ(a[0][3], 0);
 	EXPECT_EQ(a[1][0], 0);
 	EXPECT_EQ(a[1][1], 1);
 	EXPECT_EQ(a[1][2], 0);
-	EXPECT_EQ(a[1][3], 1);
+	EXPECT_EQ(a[1][3], 0);
 	EXPECT_EQ(a[2][0], 0);
 	EXPECT_EQ(a[2][1], 0);
 	EXPECT_EQ(a[2][2], 1);
-	EXPECT_EQ(a[2][3], 1);
-	EXPECT_EQ(a[3][0], 0);
-	EXPECT_EQ(a[3][1], 0);
-	EXPECT_EQ(a[3][2], 0);
+	EXPECT_EQ(a[2][3], 0);
+	EXPECT_EQ(a[3][0], 1);
+	EXPECT_EQ(a[3][1], 1);
+	EXPECT_EQ(a[3][2], 1);
 	EXPECT_EQ(a[3][3], 1);
+
+	//The translation moves a point, the matrix being column-based
+	const Vector4f moved = Matrix4f::translationMatrix(Vector3f(1, 2, 3)) * Vector4f(1, 1, 1, 1);
+	EXPECT_EQ(moved.x, 2);
+	EXPECT_EQ(moved.y, 3);
+	EXPECT_EQ(moved.z, 4);
+	EXPECT_EQ(moved.w, 1);
 }
 
 }//namespace maths
\ No newline at end of file
@@ -23,6 +23,7 @@ SOFTWARE.
 */
 
 #include <gtest/gtest.h>
+#include <thread>
 #include "paths/path.h"
 #include "paths/inverted_priority_queue.h"
 
@@ -104,6 +105,151 @@ TEST(Astar, Map_FindPath) {
 	EXPECT_TRUE(std::equal(path.begin(), path.end(), empty_path.begin()));
 }
 
+// Create a grid of nodes linked to their four neighbors.
+Map CreateGridMap(int size) {
+	Map map;
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			std::vector<NodeIndex> neighbors;
+			if (x > 0) neighbors.push_back(y * size + x - 1);
+			if (x < size - 1) neighbors.push_back(y * size + x + 1);
+			if (y > 0) neighbors.push_back((y - 1) * size + x);
+			if (y < size - 1) neighbors.push_back((y + 1) * size + x);
+			map.AddNode(Node(maths::Vector2f(static_cast<float>(x), static_cast<float>(y)), neighbors));
+		}
+	}
+	return map;
+}
+
+TEST(Astar, Map_RepeatedQueries) {
+	// The queries on a map give the same path as on a new map.
+	Map map = CreateGridMap(8);
+	const std::vector<std::pair<NodeIndex, NodeIndex>> queries{
+		{0, 63}, {63, 0}, {7, 56}, {12, 12}, {9, 54}, {0, 63}};
+	for (const auto& [start, end] : queries) {
+		Map new_map = CreateGridMap(8);
+		const std::vector<NodeIndex> path = map.FindPath(start, end);
+		EXPECT_EQ(path, new_map.FindPath(start, end));
+		ASSERT_FALSE(path.empty());
+		EXPECT_EQ(path.front(), start);
+		EXPECT_EQ(path.back(), end);
+		// The grid path goes through the Manhattan distance.
+		const int manhattan = std::abs(static_cast<int>(start % 8) - static_cast<int>(end % 8))
+			+ std::abs(static_cast<int>(start / 8) - static_cast<int>(end / 8));
+		EXPECT_EQ(path.size(), static_cast<std::size_t>(manhattan + 1));
+	}
+
+	// A node added after the queries is not seen as visited.
+	map.AddNode(Node(maths::Vector2f(10.0f, 10.0f), {}));
+	EXPECT_TRUE(map.FindPath(0, 64).empty());
+	EXPECT_EQ(map.FindPath(64, 64), std::vector<NodeIndex>{64});
+}
+
+TEST(Astar, Map_CompressedRows) {
+	// The nodes added without Node keep their neighbors in order.
+	Map map;
+	map.Reserve(4, 6);
+	const std::vector<NodeIndex> neighbors0{1, 2};
+	map.AddNode(maths::Vector2f(0.0f, 0.0f), neighbors0);
+	map.AddNode(Node(maths::Vector2f(1.0f, 0.0f), {0, 3}));
+	map.AddNode(maths::Vector2f(0.0f, 3.0f), {});
+	EXPECT_EQ(map.node_count(), 3u);
+	EXPECT_TRUE(std::ranges::equal(map.neighbors(0), neighbors0));
+	EXPECT_TRUE(map.neighbors(2).empty());
+	EXPECT_EQ(map.position(2), maths::Vector2f(0.0f, 3.0f));
+	EXPECT_EQ(map.FindPath(1, 2), (std::vector<NodeIndex>{1, 0, 2}));
+
+	// A node added after a query gets the costs of its edges.
+	const std::vector<NodeIndex> neighbors3{1, 2};
+	map.AddNode(maths::Vector2f(1.0f, 1.0f), neighbors3);
+	EXPECT_EQ(map.FindPath(3, 2), (std::vector<NodeIndex>{3, 2}));
+	EXPECT_EQ(map.FindPath(2, 1), std::vector<NodeIndex>{});
+}
+
+TEST(Astar, Map_EdgeCostsAndHeuristics) {
+	// Two ways from node 0 to node 2, the straight one going through slow terrain.
+	Map map;
+	const std::vector<NodeIndex> neighbors0{1, 3};
+	const std::vector<NodeIndex> neighbors1{0, 2};
+	const std::vector<NodeIndex> neighbors2{1, 4};
+	const std::vector<NodeIndex> neighbors3{0, 4};
+	const std::vector<NodeIndex> neighbors4{3, 2};
+	map.AddNode(maths::Vector2f(0.0f, 0.0f), neighbors0, std::vector<float>{10.0f, 1.0f});
+	map.AddNode(maths::Vector2f(1.0f, 0.0f), neighbors1, std::vector<float>{10.0f, 10.0f});
+	map.AddNode(maths::Vector2f(2.0f, 0.0f), neighbors2);
+	map.AddNode(maths::Vector2f(0.0f, 1.0f), neighbors3, std::vector<float>{1.0f, 1.0f});
+	map.AddNode(maths::Vector2f(2.0f, 1.0f), neighbors4);
+	// The terrain costs make the path go around node 1.
+	EXPECT_EQ(map.FindPath(0, 2), (std::vector<NodeIndex>{0, 3, 4, 2}));
+	EXPECT_EQ(map.FindPath(0, 2, ZeroHeuristic()), (std::vector<NodeIndex>{0, 3, 4, 2}));
+
+	// A given cost is kept even when it looks like no cost at all.
+	Map negative;
+	const std::vector<NodeIndex> neighbors_start{1, 2};
+	const std::vector<NodeIndex> neighbors_middle{2};
+	negative.AddNode(maths::Vector2f(0.0f, 0.0f), neighbors_start, std::vector<float>{-1.0f, 0.5f});
+	negative.AddNode(maths::Vector2f(1.0f, 0.0f), neighbors_middle);
+	negative.AddNode(maths::Vector2f(2.0f, 0.0f), {});
+	EXPECT_EQ(negative.FindPath(0, 2, ZeroHeuristic()), (std::vector<NodeIndex>{0, 1, 2}));
+
+	// Every admissible heuristic finds a path of the same length on a grid.
+	Map grid = CreateGridMap(16);
+	const std::size_t length = grid.FindPath(3, 250, EuclideanHeuristic()).size();
+	EXPECT_EQ(length, 7u + 15u + 1u);
+	EXPECT_EQ(grid.FindPath(3, 250, ManhattanHeuristic()).size(), length);
+	EXPECT_EQ(grid.FindPath(3, 250, OctileHeuristic()).size(), length);
+	EXPECT_EQ(grid.FindPath(3, 250, ZeroHeuristic()).size(), length);
+
+	EXPECT_FLOAT_EQ(ManhattanHeuristic()(3.0f, -4.0f), 7.0f);
+	EXPECT_FLOAT_EQ(OctileHeuristic()(3.0f, -4.0f), 4.0f + 3.0f * (std::sqrt(2.0f) - 1.0f));
+	EXPECT_FLOAT_EQ(EuclideanHeuristic()(3.0f, -4.0f), 5.0f);
+}
+
+TEST(Astar, Map_FindPathsBatch) {
+	// The batch gives the paths of the queries made one by one, for any
+	// thread count.
+	Map map = CreateGridMap(20);
+	map.AddNode(maths::Vector2f(30.0f, 30.0f), {});
+	std::vector<PathQuery> queries;
+	for (NodeIndex i = 0; i < 100; ++i) {
+		queries.push_back({(i * 37) % 400, (i * 91 + 5) % 400});
+	}
+	// Nodes out of reach give empty paths.
+	queries.push_back({0, 400});
+	std::vector<std::vector<NodeIndex>> expected_paths;
+	for (const PathQuery& query : queries) {
+		expected_paths.push_back(map.FindPath(query.start_node, query.end_node));
+	}
+	for (std::size_t thread_count : {1, 3, 8}) {
+		threading::ThreadPool pool(thread_count);
+		EXPECT_EQ(map.FindPaths(queries, pool), expected_paths);
+	}
+	threading::ThreadPool pool(2);
+	EXPECT_TRUE(map.FindPaths(std::vector<PathQuery>{}, pool).empty());
+
+	// A context of its own searches the map without changing it.
+	SearchContext context;
+	const Map& shared_map = map;
+	EXPECT_EQ(shared_map.FindPath(queries[1].start_node, queries[1].end_node, context, EuclideanHeuristic()),
+		expected_paths[1]);
+
+	// Several threads run their batches on the same map at once.
+	std::vector<std::vector<std::vector<NodeIndex>>> batch_paths(4);
+	std::vector<std::thread> threads;
+	for (std::size_t i = 0; i < batch_paths.size(); ++i) {
+		threads.emplace_back([&shared_map, &queries, &batch_paths, i]() {
+			threading::ThreadPool batch_pool(2);
+			batch_paths[i] = shared_map.FindPaths(queries, batch_pool);
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	for (const std::vector<std::vector<NodeIndex>>& paths : batch_paths) {
+		EXPECT_EQ(paths, expected_paths);
+	}
+}
+
 TEST(Astar, Astar_PriorityQueue) {
 	// Check if the queue is empty.
 	PriorityQueue<NodeIndex, float> queue;
@@ -125,4 +271,40 @@ TEST(Astar, Astar_PriorityQueue) {
 	EXPECT_TRUE(queue.get() == node_index_2);
 }
 
+TEST(Astar, Astar_IndexedPriorityQueue) {
+	IndexedPriorityQueue<NodeIndex, float> queue;
+	EXPECT_TRUE(queue.empty());
+
+	// The items come out from the lowest to the highest priority.
+	const std::vector<float> priorities{5.0f, 3.0f, 8.0f, 1.0f, 4.0f, 9.0f, 2.0f, 7.0f, 6.0f, 0.5f};
+	for (NodeIndex i = 0; i < priorities.size(); ++i) {
+		queue.put(i, priorities[i]);
+	}
+	EXPECT_EQ(queue.size(), priorities.size());
+
+	// Putting an item again lowers its priority without adding a copy.
+	queue.put(5, 0.0f);
+	queue.put(3, 10.0f);
+	EXPECT_EQ(queue.size(), priorities.size());
+	EXPECT_FLOAT_EQ(queue.priority(5), 0.0f);
+	EXPECT_FLOAT_EQ(queue.priority(3), 1.0f);
+	const std::vector<NodeIndex> expected_order{5, 9, 3, 6, 1, 4, 0, 8, 7, 2};
+	for (NodeIndex expected : expected_order) {
+		EXPECT_EQ(queue.get(), expected);
+		EXPECT_FALSE(queue.contains(expected));
+	}
+	EXPECT_TRUE(queue.empty());
+
+	// An item can come back once out of the queue, and clear forgets them.
+	queue.put(2, 3.0f);
+	queue.put(12, 1.0f);
+	EXPECT_TRUE(queue.contains(12));
+	queue.clear();
+	EXPECT_TRUE(queue.empty());
+	EXPECT_FALSE(queue.contains(2));
+	EXPECT_FALSE(queue.contains(12));
+	queue.put(12, 4.0f);
+	EXPECT_EQ(queue.get(), 12u);
+}
+
 }  // namespace astar
@@ -117,6 +117,53 @@ TEST(Maths, Ray_interceptABB3)
 	ASSERT_FALSE(ray.IntersectAABB3(aabb));
 }
 
+TEST(Maths, SlabRay3_IntersectAABB3)
+{
+	const AABB3 aabb{ Vector3f{ -0.5f,-0.5f,-0.5f }, Vector3f{ 0.5f,0.5f,0.5f } };
+	float tmin;
+	float tmax;
+
+	// inside intersection, the box is entered behind the origin
+	SlabRay3 ray{ Vector3f{ -0.1f,-0.1f,-0.1f }, Vector3f{ 1.0f,1.0f,1.0f } };
+	ASSERT_TRUE(ray.IntersectAABB3(aabb, tmin, tmax));
+	EXPECT_FLOAT_EQ(tmin, -0.4f);
+	EXPECT_FLOAT_EQ(tmax, 0.6f);
+
+	// negative direction, entering through the top right corner
+	ray = SlabRay3{ Vector3f{ 2.0f,0.0f,0.0f }, Vector3f{ -1.0f,0.0f,0.0f } };
+	EXPECT_EQ(ray.sign(0), 1);
+	EXPECT_EQ(ray.sign(1), 0);
+	ASSERT_TRUE(ray.IntersectAABB3(aabb, tmin, tmax));
+	EXPECT_FLOAT_EQ(tmin, 1.5f);
+	EXPECT_FLOAT_EQ(tmax, 2.5f);
+	// the box is after the max distance
+	EXPECT_FALSE(ray.IntersectAABB3(aabb.bottom_left(), aabb.top_right(), 1.0f, tmin, tmax));
+
+	// same answers as Ray3
+	const Vector3f direction{ 1.0f,1.0f,1.0f };
+	for (const Vector3f origin : { Vector3f{ -1.0f,-1.0f,-1.0f }, Vector3f{ -0.5f,-2.0f,-2.0f }, Vector3f{ 1.0f,1.0f,1.0f } })
+	{
+		Ray3 reference{ origin, direction };
+		EXPECT_EQ(SlabRay3(reference).IntersectAABB3(aabb, tmin, tmax), reference.IntersectAABB3(aabb));
+	}
+}
+
+TEST(Maths, Ray_IntersectPlane)
+{
+	// the plane does not go through the origin
+	const Plane plane{ Vector3f{ 0.0f,-5.0f,0.0f }, Vector3f{ 0.0f,1.0f,0.0f } };
+	Vector3f hit_position;
+	Ray3 ray{ Vector3f{ 0.0f,0.0f,0.0f }, Vector3f{ 0.0f,-1.0f,0.0f } };
+	ASSERT_TRUE(ray.IntersectPlane(plane, hit_position));
+	EXPECT_EQ(hit_position, Vector3f(0.0f, -5.0f, 0.0f));
+
+	// going away from the plane or parallel to it
+	ray = Ray3{ Vector3f{ 0.0f,0.0f,0.0f }, Vector3f{ 0.0f,1.0f,0.0f } };
+	EXPECT_FALSE(ray.IntersectPlane(plane, hit_position));
+	ray = Ray3{ Vector3f{ 0.0f,0.0f,0.0f }, Vector3f{ 1.0f,0.0f,0.0f } };
+	EXPECT_FALSE(ray.IntersectPlane(plane, hit_position));
+}
+
 TEST(Maths, Ray_intersectCircle)
 {
 	Vector2f center{ 0.0f,0.0f };
@@ -0,0 +1,146 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "raytracing/ray_packet.h"
+#include "raytracing/wide_box.h"
+#include "maths/ray3.h"
+
+namespace raytracing {
+
+// Test that each ray of a packet gets the same hit as when
+// it is intersected alone with Ray3::IntersectSphere
+TEST(Raytracing, Packet_IntersectSphere)
+{
+	std::mt19937 generator(3);
+	std::uniform_real_distribution<float> spread(-0.3f, 0.3f);
+	const maths::Sphere sphere(2.0f, maths::Vector3f(0.5f, -0.2f, -10.0f));
+
+	for (int test = 0; test < 100; ++test)
+	{
+		RayPacket packet;
+		maths::Vector3f directions[kPacketSize];
+		for (int lane = 0; lane < kPacketSize; ++lane)
+		{
+			directions[lane] = maths::Vector3f(spread(generator), spread(generator), -1.0f).Normalized();
+			packet.Set(lane, maths::Vector3f(0.0f, 0.0f, 0.0f), directions[lane]);
+		}
+		PacketHit hit;
+		hit.Reset(1000000.0f);
+		// The last ray is inactive and must be left untouched
+		IntersectSpherePacket(sphere.center(), sphere.radius(), 5, packet, hit, 0x7);
+
+		for (int lane = 0; lane < kPacketSize - 1; ++lane)
+		{
+			maths::Ray3 ray(maths::Vector3f(0.0f, 0.0f, 0.0f), directions[lane]);
+			maths::Vector3f hit_position;
+			float distance;
+			if (ray.IntersectSphere(sphere, hit_position, distance))
+			{
+				EXPECT_EQ(hit.primitive[lane], 5);
+				EXPECT_FLOAT_EQ(hit.distance[lane], distance);
+			}
+			else
+			{
+				EXPECT_EQ(hit.primitive[lane], -1);
+			}
+		}
+		EXPECT_EQ(hit.primitive[kPacketSize - 1], -1);
+	}
+}
+
+// Test the mask returned by the packet box test
+TEST(Raytracing, Packet_IntersectBox)
+{
+	RayPacket packet;
+	packet.Set(0, maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Vector3f(0.0f, 0.0f, -1.0f));
+	packet.Set(1, maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Vector3f(0.0f, 0.0f, 1.0f));
+	packet.Set(2, maths::Vector3f(5.0f, 0.0f, 0.0f), maths::Vector3f(0.0f, 0.0f, -1.0f));
+	packet.Set(3, maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Vector3f(0.0f, 0.0f, -1.0f));
+	PacketHit hit;
+	hit.Reset(1000000.0f);
+	// The last ray already hit something in front of the box
+	hit.distance[3] = 2.0f;
+
+	float entry_distance;
+	const int mask = IntersectBoxPacket(
+		maths::Vector3f(-1.0f, -1.0f, -6.0f), maths::Vector3f(1.0f, 1.0f, -4.0f),
+		packet, hit, kPacketFullMask, entry_distance);
+	EXPECT_EQ(mask, 0x1);
+	EXPECT_FLOAT_EQ(entry_distance, 4.0f);
+}
+
+// Test that the four boxes tested at once give the same
+// answers as the scalar slab test
+TEST(Raytracing, WideBox_Intersect)
+{
+	std::mt19937 generator(5);
+	std::uniform_real_distribution<float> position(-4.0f, 4.0f);
+	std::uniform_real_distribution<float> size(0.1f, 2.0f);
+	std::uniform_real_distribution<float> spread(-1.0f, 1.0f);
+	for (int test = 0; test < 100; ++test)
+	{
+		WideBox boxes;
+		maths::AABB3 aabbs[kWideBoxSize];
+		for (int lane = 0; lane < kWideBoxSize; ++lane)
+		{
+			const maths::Vector3f center(position(generator), position(generator), position(generator));
+			const maths::Vector3f extent(size(generator), size(generator), size(generator));
+			aabbs[lane] = maths::AABB3(center - extent, center + extent);
+			boxes.Set(lane, aabbs[lane]);
+		}
+		const maths::SlabRay3 ray(maths::Vector3f(0.0f, 0.0f, 5.0f),
+			maths::Vector3f(spread(generator), spread(generator), -1.0f).Normalized());
+
+		float tmin[kWideBoxSize];
+		const int mask = IntersectWideBox(ray, boxes, 8.0f, tmin);
+		for (int lane = 0; lane < kWideBoxSize; ++lane)
+		{
+			float expected_tmin;
+			float expected_tmax;
+			const bool hit = ray.IntersectAABB3(aabbs[lane].bottom_left(), aabbs[lane].top_right(),
+				8.0f, expected_tmin, expected_tmax);
+			ASSERT_EQ(hit, (mask & (1 << lane)) != 0);
+			if (hit)
+			{
+				EXPECT_FLOAT_EQ(tmin[lane], expected_tmin);
+			}
+		}
+	}
+
+	//An empty lane is never hit
+	WideBox boxes;
+	for (int lane = 0; lane < kWideBoxSize; ++lane)
+	{
+		boxes.SetEmpty(lane);
+	}
+	float tmin[kWideBoxSize];
+	EXPECT_EQ(IntersectWideBox(maths::SlabRay3(maths::Vector3f(), maths::Vector3f(0.0f, 0.0f, -1.0f)),
+		boxes, 100.0f, tmin), 0);
+}
+
+}// namespace raytracing
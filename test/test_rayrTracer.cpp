@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 
 #include "raytracing/ray_tracer.h"
+#include "raytracing/sampling.h"
 
 namespace raytracing {
 
@@ -17,16 +18,17 @@ TEST(Raytracing, Color_Output)
 	Material material_test(1.0f, red);
 	//Sphere is placed around the middle of the frame
 	maths::Sphere sphere(50.0f, maths::Vector3f(0.0f, 0.0f, -80.0f));
-	sphere.set_material(material_test);
+	sphere.set_material_index(0);
 
 	std::vector<maths::Sphere> spheres;
 	spheres.push_back(sphere);
+	std::vector<Material> materials{ material_test };
 
 	PointLight light;
 	std::vector<maths::Plane> planes;
 
 	Raytracer raytracer;
-	raytracer.SetScene(spheres, planes, light, heigth, width, fov, bias);
+	raytracer.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
 	raytracer.Render();
 
 	maths::Vector3f background_color{ 150.0f,200.0f,255.0f };
@@ -66,30 +68,30 @@ TEST(Raytracing, Correct_Depth_Rendering)
 	maths::Sphere sphere(50.0f, maths::Vector3f(0.0f, 0.0f, -80.0f));
 	maths::Sphere sphere2(50.0f, maths::Vector3f(0.0f, 0.0f, -85.0f));
 
-	sphere.set_material(material_test);
-	sphere2.set_material(material_test2);
+	sphere.set_material_index(0);
+	sphere2.set_material_index(1);
 
 	std::vector<maths::Sphere> spheres;
 	spheres.push_back(sphere2);
 	spheres.push_back(sphere);
+	std::vector<Material> materials{ material_test, material_test2 };
 
 	PointLight light;
 	std::vector<maths::Plane> planes;
 
 	Raytracer raytracer;
-	raytracer.SetScene(spheres, planes, light, heigth, width, fov, bias);
+	raytracer.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
 
 	maths::Vector3f ray_origin = maths::Vector3f(0.0f, 0.0f, 0.0f);
-	maths::Vector3f ray_direction = maths::Vector3f(1.0f, 0.0f, 0.0f);
+	maths::Vector3f ray_direction = maths::Vector3f(0.0f, 0.0f, -1.0f);
 
 	maths::Ray3 ray(ray_origin, ray_direction);
-	Material hit_material;
 	HitInfos hit_infos;
 	float distance;
-	raytracer.ObjectIntersect(ray, hit_material, hit_infos, distance);
+	ASSERT_TRUE(raytracer.ObjectIntersect(ray, hit_infos, distance));
 
-	maths::Vector3f expected_material_color = spheres[1].material().color();
-	maths::Vector3f tested_material_color = hit_material.color();
+	maths::Vector3f expected_material_color = materials[spheres[1].material_index()].color();
+	maths::Vector3f tested_material_color = raytracer.materials()[hit_infos.material_index].color();
 
 	//Test if the returned material color is the material from the closest sphere
 	// and not the first one in the list;
@@ -115,15 +117,16 @@ TEST(Raytracing, ShadowRay)
 	//PointLight is placed at the right of the scene
 	light.position = maths::Vector3f(30.0f, 0.0f, 0.0f);
 
-	sphere.set_material(material_test);
+	sphere.set_material_index(0);
 
 	std::vector<maths::Sphere> spheres;
 	spheres.push_back(sphere);
+	std::vector<Material> materials{ material_test };
 
 	std::vector<maths::Plane> planes;
 
 	Raytracer raytracer;
-	raytracer.SetScene(spheres, planes, light, heigth, width, fov, bias);
+	raytracer.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
 
 	//Shadow ray has an origin just on the left of the sphere,
 	//and goes to the direction of the light, on his right
@@ -136,7 +139,7 @@ TEST(Raytracing, ShadowRay)
 	EXPECT_FALSE(is_not_in_shadow);
 }
 
-// Test that will make the rendering and create a .ppn image
+// Test that will make the rendering and create a .ppm image
 // of a 4 sphere scene
 TEST(Raytracing, Raytracing_ImageOutput)
 {
@@ -157,7 +160,7 @@ TEST(Raytracing, Raytracing_ImageOutput)
 	double bias = 1e-4;
 
 	maths::Plane plane(maths::Vector3f(0.0f, -20.0f, 0.0f), maths::Vector3f(0.0f, 1.0f, 0.0f));
-	plane.SetMaterial(material_test4);
+	plane.set_material_index(3);
 
 	maths::Sphere sphere1(6.0f, maths::Vector3f(-5.0f, 0.0f, -16.0f));
 	maths::Sphere sphere3(2.0f, maths::Vector3f(4.0f, 0.0f, -8.0f));
@@ -165,10 +168,11 @@ TEST(Raytracing, Raytracing_ImageOutput)
 	maths::Sphere sphere5(75.0f, maths::Vector3f(0.0f, -84.0f, -10.0f));
 
 
-	sphere1.set_material(material_test);
-	sphere3.set_material(material_test2);
-	sphere4.set_material(material_test3);
-	sphere5.set_material(material_test4);
+	sphere1.set_material_index(0);
+	sphere3.set_material_index(1);
+	sphere4.set_material_index(2);
+	sphere5.set_material_index(3);
+	std::vector<Material> materials{ material_test, material_test2, material_test3, material_test4 };
 
 
 	PointLight light;
@@ -181,8 +185,703 @@ TEST(Raytracing, Raytracing_ImageOutput)
 	std::vector<maths::Plane> planes;
 		
 	Raytracer raytracer;
-	raytracer.SetScene(spheres, planes, light, heigth, width, fov, bias);
+	raytracer.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
 	raytracer.Render();
+	EXPECT_TRUE(raytracer.WriteImage());
 }
 	
+// Test that rendering with the bounding volume hierarchy gives
+// the same image as testing every sphere
+TEST(Raytracing, Bvh_SameImageAsBruteForce)
+{
+	int width = 64;
+	int heigth = 48;
+	float fov = 51.52f;
+	double bias = 1e-4;
+
+	std::vector<maths::Sphere> spheres;
+	std::vector<Material> materials;
+	for (int i = 0; i < 10; ++i)
+	{
+		for (int j = 0; j < 10; ++j)
+		{
+			maths::Sphere sphere(0.8f, maths::Vector3f(-9.0f + 2.0f * i, -9.0f + 2.0f * j, -30.0f - i));
+			sphere.set_material_index(static_cast<std::uint32_t>(materials.size()));
+			materials.push_back(Material(0.3f, maths::Vector3f(25.0f * i, 25.0f * j, 128.0f)));
+			spheres.push_back(sphere);
+		}
+	}
+	PointLight light;
+	std::vector<maths::Plane> planes;
+
+	Raytracer brute_force;
+	brute_force.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
+	brute_force.set_acceleration(Acceleration::kBruteForce);
+	brute_force.Render();
+
+	Raytracer bvh;
+	bvh.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
+	bvh.set_acceleration(Acceleration::kBvh);
+	bvh.Render();
+
+	const std::span<const maths::Vector3f> expected = brute_force.frameBuffer();
+	const std::span<const maths::Vector3f> tested = bvh.frameBuffer();
+	ASSERT_EQ(expected.size(), tested.size());
+	for (std::size_t i = 0; i < expected.size(); ++i)
+	{
+		EXPECT_EQ(expected[i], tested[i]);
+	}
+}
+
+// Test that culling the primary rays to the camera frustum without a bvh
+// keeps the spheres behind the camera in the reflexions
+TEST(Raytracing, BruteForce_FrustumCullingKeepsReflexions)
+{
+	const maths::Vector3f red(255.0f, 0.0f, 0.0f);
+	const maths::Vector3f green(0.0f, 255.0f, 0.0f);
+	//The mirror fills the center of the image, the green sphere is behind the camera
+	maths::Sphere mirror(4.0f, maths::Vector3f(0.0f, 0.0f, -10.0f));
+	maths::Sphere behind(4.0f, maths::Vector3f(0.0f, 0.0f, 10.0f));
+	behind.set_material_index(1);
+	std::vector<maths::Sphere> spheres{ mirror, behind };
+	std::vector<Material> materials{ Material(0.5f, red), Material(0.0f, green) };
+	std::vector<maths::Plane> planes;
+	PointLight light;
+
+	for (const RenderMode render_mode : { RenderMode::kScalar, RenderMode::kPacket })
+	{
+		Raytracer brute_force;
+		brute_force.SetScene(spheres, planes, materials, light, 16, 16, 51.52f, 1e-4);
+		brute_force.set_acceleration(Acceleration::kBruteForce);
+		brute_force.set_render_mode(render_mode);
+		brute_force.Render();
+
+		Raytracer bvh;
+		bvh.SetScene(spheres, planes, materials, light, 16, 16, 51.52f, 1e-4);
+		bvh.set_acceleration(Acceleration::kBvh);
+		bvh.set_render_mode(render_mode);
+		bvh.Render();
+
+		const std::span<const maths::Vector3f> expected = bvh.frameBuffer();
+		const std::span<const maths::Vector3f> tested = brute_force.frameBuffer();
+		ASSERT_EQ(expected.size(), tested.size());
+		for (std::size_t i = 0; i < expected.size(); ++i)
+		{
+			EXPECT_EQ(expected[i], tested[i]);
+		}
+		//The center of the mirror reflects the green sphere
+		EXPECT_GT(tested[8 + 8 * 16].y, 0.0f);
+	}
+}
+	
+// Test that the tiles cover the image and that the image
+// does not depend on the number of threads
+TEST(Raytracing, Tiles_SameImageForAnyThreadCount)
+{
+	int width = 70;
+	int heigth = 37;
+	float fov = 51.52f;
+	double bias = 1e-4;
+
+	maths::Sphere sphere(6.0f, maths::Vector3f(-5.0f, 0.0f, -16.0f));
+	maths::Sphere sphere2(2.0f, maths::Vector3f(4.0f, 0.0f, -8.0f));
+	sphere2.set_material_index(1);
+	std::vector<maths::Sphere> spheres{ sphere, sphere2 };
+	std::vector<Material> materials{
+		Material(0.2f, maths::Vector3f(255.0f, 0.0f, 0.0f)),
+		Material(0.1f, maths::Vector3f(0.0f, 0.0f, 255.0f)) };
+	std::vector<maths::Plane> planes;
+	PointLight light;
+
+	Raytracer single_thread;
+	single_thread.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
+	single_thread.set_thread_count(1);
+	single_thread.Render();
+
+	Raytracer multi_thread;
+	multi_thread.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
+	multi_thread.set_thread_count(4);
+	multi_thread.set_tile_size(8);
+	multi_thread.Render();
+
+	//Tiles of 8 pixels: 9 columns and 5 rows, the last ones being cut
+	const std::vector<TileStats>& tiles = multi_thread.tile_stats();
+	ASSERT_EQ(tiles.size(), 45u);
+	int covered_pixels = 0;
+	for (const TileStats& tile : tiles)
+	{
+		covered_pixels += tile.width * tile.height;
+		EXPECT_GE(tile.milliseconds, 0.0);
+	}
+	EXPECT_EQ(covered_pixels, width * heigth);
+
+	const std::span<const maths::Vector3f> expected = single_thread.frameBuffer();
+	const std::span<const maths::Vector3f> tested = multi_thread.frameBuffer();
+	for (std::size_t i = 0; i < expected.size(); ++i)
+	{
+		EXPECT_EQ(expected[i], tested[i]);
+	}
+}
+
+// Test that tracing primary rays by packets gives the same image
+// as tracing them one by one, including on incomplete packets
+TEST(Raytracing, Packet_SameImageAsScalar)
+{
+	int width = 45;
+	int heigth = 33;
+	float fov = 51.52f;
+	double bias = 1e-4;
+
+	std::vector<maths::Sphere> spheres;
+	std::vector<Material> materials;
+	for (int i = 0; i < 6; ++i)
+	{
+		maths::Sphere sphere(1.5f + 0.3f * i, maths::Vector3f(-8.0f + 3.0f * i, 1.0f - 0.5f * i, -20.0f + i));
+		sphere.set_material_index(i);
+		materials.push_back(Material(0.3f, maths::Vector3f(40.0f * i, 255.0f - 40.0f * i, 100.0f)));
+		spheres.push_back(sphere);
+	}
+	PointLight light;
+	std::vector<maths::Plane> planes;
+
+	for (Acceleration acceleration : { Acceleration::kBruteForce, Acceleration::kBvh })
+	{
+		Raytracer scalar;
+		scalar.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
+		scalar.set_acceleration(acceleration);
+		scalar.set_render_mode(RenderMode::kScalar);
+		scalar.Render();
+
+		Raytracer packet;
+		packet.SetScene(spheres, planes, materials, light, heigth, width, fov, bias);
+		packet.set_acceleration(acceleration);
+		packet.set_render_mode(RenderMode::kPacket);
+		packet.set_tile_size(7);
+		packet.Render();
+
+		const std::span<const maths::Vector3f> expected = scalar.frameBuffer();
+		const std::span<const maths::Vector3f> tested = packet.frameBuffer();
+		for (std::size_t i = 0; i < expected.size(); ++i)
+		{
+			EXPECT_EQ(expected[i], tested[i]);
+		}
+	}
+}
+
+// Test that the spheres are stored as arrays keeping their index
+// in the shared material table, which resolves the material of a hit
+TEST(Raytracing, SphereArrays_MaterialTable)
+{
+	std::vector<Material> materials{
+		Material(0.5f, maths::Vector3f(255.0f, 0.0f, 0.0f)),
+		Material(0.0f, maths::Vector3f(0.0f, 128.0f, 0.0f)) };
+	std::vector<maths::Sphere> spheres;
+	for (int i = 0; i < 4; ++i)
+	{
+		maths::Sphere sphere(1.0f + i, maths::Vector3f(2.0f * i, 0.0f, -10.0f));
+		sphere.set_material_index(i % 2);
+		spheres.push_back(sphere);
+	}
+	maths::Plane plane(maths::Vector3f(0.0f, -20.0f, 0.0f), maths::Vector3f(0.0f, 1.0f, 0.0f));
+	plane.set_material_index(1);
+	std::vector<maths::Plane> planes{ plane };
+
+	Raytracer raytracer;
+	raytracer.SetScene(spheres, planes, materials, PointLight(), 10, 10, 51.52f, 1e-4);
+
+	const SphereArrays& arrays = raytracer.spheres();
+	ASSERT_EQ(arrays.size(), spheres.size());
+	ASSERT_EQ(raytracer.materials().size(), 2u);
+	//The spheres are stored in the order of the leaves of the hierarchy
+	for (const maths::Sphere& sphere : spheres)
+	{
+		std::size_t i = 0;
+		while (i < arrays.size() && arrays.center(i) != sphere.center())
+		{
+			++i;
+		}
+		ASSERT_LT(i, arrays.size());
+		EXPECT_EQ(arrays.radius[i], sphere.radius());
+		EXPECT_EQ(arrays.material_index[i], sphere.material_index());
+	}
+
+	maths::Ray3 ray(maths::Vector3f(6.0f, 0.0f, 0.0f), maths::Vector3f(0.0f, 0.0f, -1.0f));
+	HitInfos hit_infos;
+	float distance;
+	ASSERT_TRUE(raytracer.ObjectIntersect(ray, hit_infos, distance));
+	EXPECT_EQ(hit_infos.material_index, 1u);
+	ray = maths::Ray3(maths::Vector3f(-20.0f, 0.0f, 0.0f), maths::Vector3f(0.0f, -1.0f, 0.0f));
+	ASSERT_TRUE(raytracer.ObjectIntersect(ray, hit_infos, distance));
+	EXPECT_EQ(hit_infos.material_index, plane.material_index());
+}
+
+// Test the color of a reflective sphere whose reflexion ray
+// goes to the background, with and without early termination
+TEST(Raytracing, RayCast_ReflexionContribution)
+{
+	maths::Vector3f red(255.0f, 0.0f, 0.0f);
+	maths::Vector3f background_color{ 150.0f,200.0f,255.0f };
+	maths::Sphere sphere(2.0f, maths::Vector3f(0.0f, 0.0f, -10.0f));
+	std::vector<maths::Sphere> spheres{ sphere };
+	std::vector<Material> materials{ Material(0.5f, red) };
+	std::vector<maths::Plane> planes;
+	PointLight light;
+
+	Raytracer raytracer;
+	raytracer.SetScene(spheres, planes, materials, light, 10, 10, 51.52f, 1e-4);
+
+	//The ray hits the sphere at (0, 0, -8) and is reflected back to the background
+	const maths::Vector3f hit_position(0.0f, 0.0f, -8.0f);
+	const float light_value = maths::Vector3f::Dot(maths::Vector3f(0.0f, 0.0f, 1.0f),
+		maths::Vector3f(light.position - hit_position).Normalized());
+	const maths::Vector3f origin(0.0f, 0.0f, 0.0f);
+	const maths::Vector3f direction(0.0f, 0.0f, -1.0f);
+
+	const maths::Vector3f color = raytracer.RayCast(origin, direction);
+	EXPECT_EQ(color, red * light_value + background_color * 0.5f);
+
+	//No reflexion is followed once its contribution is below the threshold
+	raytracer.set_min_contribution(0.6f);
+	const maths::Vector3f color_without_reflexion = raytracer.RayCast(origin, direction);
+	EXPECT_EQ(color_without_reflexion, red * light_value);
+}
+
+// Test that a ray bouncing between two mirrors stops at the maximum depth
+TEST(Raytracing, RayCast_MaxDepth)
+{
+	maths::Vector3f red(255.0f, 0.0f, 0.0f);
+	maths::Sphere sphere(2.0f, maths::Vector3f(0.0f, 0.0f, -10.0f));
+	maths::Sphere sphere2(2.0f, maths::Vector3f(0.0f, 0.0f, 10.0f));
+	std::vector<maths::Sphere> spheres{ sphere, sphere2 };
+	std::vector<Material> materials{ Material(1.0f, red) };
+	std::vector<maths::Plane> planes;
+	PointLight light;
+
+	Raytracer raytracer;
+	raytracer.SetScene(spheres, planes, materials, light, 10, 10, 51.52f, 1e-4);
+	raytracer.set_min_contribution(0.0f);
+	const maths::Vector3f origin(0.0f, 0.0f, 0.0f);
+	const maths::Vector3f direction(0.0f, 0.0f, -1.0f);
+
+	//Each hit brings the same amount of red
+	raytracer.set_max_depth(0);
+	const float one_hit = raytracer.RayCast(origin, direction).x;
+	raytracer.set_max_depth(9);
+	const float ten_hits = raytracer.RayCast(origin, direction).x;
+	EXPECT_NEAR(ten_hits - 150.0f, 10.0f * (one_hit - 150.0f), 1e-2f);
+
+	//A deep path does not use the stack
+	raytracer.set_max_depth(100000);
+	EXPECT_TRUE(std::isfinite(raytracer.RayCast(origin, direction).x));
+}
+
+// Test rendering into a buffer owned by the caller, on a scene
+// whose sphere arrays and planes were moved into the raytracer
+TEST(Raytracing, RenderInto_CallerBuffer)
+{
+	int width = 20;
+	int heigth = 10;
+	maths::Sphere sphere(6.0f, maths::Vector3f(0.0f, 0.0f, -16.0f));
+	std::vector<maths::Sphere> spheres{ sphere };
+	std::vector<Material> materials{ Material(0.2f, maths::Vector3f(255.0f, 0.0f, 0.0f)) };
+
+	Raytracer reference;
+	reference.SetScene(spheres, std::vector<maths::Plane>(), materials, PointLight(), heigth, width, 51.52f, 1e-4);
+	reference.Render();
+
+	SphereArrays sphere_arrays;
+	sphere_arrays.push_back(sphere.center(), sphere.radius(), 0);
+	Raytracer raytracer;
+	raytracer.SetScene(std::move(sphere_arrays), std::move(materials), std::vector<maths::Plane>(),
+		PointLight(), heigth, width, 51.52f, 1e-4);
+
+	//A buffer of the wrong size is left as it is
+	std::vector<maths::Vector3f> output(width * heigth - 1, maths::Vector3f(-1.0f, -1.0f, -1.0f));
+	EXPECT_FALSE(raytracer.RenderInto(output));
+	EXPECT_EQ(output[0], maths::Vector3f(-1.0f, -1.0f, -1.0f));
+
+	output.resize(width * heigth);
+	EXPECT_TRUE(raytracer.RenderInto(output));
+
+	const std::span<const maths::Vector3f> expected = reference.frameBuffer();
+	ASSERT_EQ(expected.size(), output.size());
+	for (std::size_t i = 0; i < output.size(); ++i)
+	{
+		EXPECT_EQ(expected[i], output[i]);
+	}
+	//The frame buffer of the raytracer was not written
+	EXPECT_EQ(raytracer.frameBuffer()[0], maths::Vector3f(0.0f, 0.0f, 0.0f));
+}
+
+// Test that progressive passes start from the plain render and only
+// keep sampling the pixels whose color varies inside of them
+TEST(Raytracing, Progressive_AdaptiveSampling)
+{
+	int width = 20;
+	int heigth = 10;
+	maths::Sphere sphere(6.0f, maths::Vector3f(0.0f, 0.0f, -16.0f));
+	std::vector<maths::Sphere> spheres{ sphere };
+	std::vector<Material> materials{ Material(0.2f, maths::Vector3f(255.0f, 0.0f, 0.0f)) };
+
+	Raytracer reference;
+	reference.SetScene(spheres, std::vector<maths::Plane>(), materials, PointLight(), heigth, width, 51.52f, 1e-4);
+	reference.Render();
+
+	Raytracer raytracer;
+	raytracer.SetScene(spheres, std::vector<maths::Plane>(), materials, PointLight(), heigth, width, 51.52f, 1e-4);
+	EXPECT_EQ(raytracer.RenderPass(), width * heigth);
+	const std::span<const maths::Vector3f> expected = reference.frameBuffer();
+	const std::span<const maths::Vector3f> first_pass = raytracer.frameBuffer();
+	for (std::size_t i = 0; i < first_pass.size(); ++i)
+	{
+		EXPECT_EQ(expected[i], first_pass[i]);
+	}
+
+	raytracer.set_min_samples(4);
+	raytracer.RenderProgressive(std::chrono::hours(1), 64);
+	const std::span<const std::uint32_t> sample_counts = raytracer.sample_counts();
+	//The corner only sees the background, it stops at the minimum
+	EXPECT_EQ(sample_counts[0], 4u);
+	//The edge of the sphere keeps being sampled
+	std::uint32_t max_samples = 0;
+	for (const std::uint32_t count : sample_counts)
+	{
+		max_samples = std::max(max_samples, count);
+	}
+	EXPECT_GT(max_samples, 4u);
+
+	//A new scene resets the samples, and the first pass is always done
+	raytracer.SetScene(spheres, std::vector<maths::Plane>(), materials, PointLight(), heigth, width, 51.52f, 1e-4);
+	EXPECT_EQ(raytracer.progressive_pass_count(), 0);
+	EXPECT_EQ(raytracer.RenderProgressive(std::chrono::milliseconds(0), 64), 1);
+	EXPECT_EQ(raytracer.sample_counts()[0], 1u);
+}
+
+// Test that the occlusion query only sees the objects before the max
+// distance, with and without the bvh
+TEST(Raytracing, Occluded_MaxDistance)
+{
+	std::vector<maths::Sphere> spheres;
+	for (int i = 0; i < 20; ++i)
+	{
+		spheres.push_back(maths::Sphere(0.5f, maths::Vector3f(3.0f * i, 5.0f, -10.0f)));
+	}
+	spheres.push_back(maths::Sphere(1.0f, maths::Vector3f(0.0f, 0.0f, -10.0f)));
+
+	for (const Acceleration acceleration : { Acceleration::kBruteForce, Acceleration::kBvh })
+	{
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, std::vector<maths::Plane>(), std::vector<Material>{ Material() },
+			PointLight(), 10, 10, 51.52f, 1e-4);
+		raytracer.set_acceleration(acceleration);
+		const maths::Vector3f origin(0.0f, 0.0f, 0.0f);
+		const maths::Vector3f direction(0.0f, 0.0f, -1.0f);
+
+		EXPECT_TRUE(raytracer.Occluded(origin, direction, 100.0f));
+		//The light is in front of the sphere
+		EXPECT_FALSE(raytracer.Occluded(origin, direction, 5.0f));
+		EXPECT_FALSE(raytracer.Occluded(origin, maths::Vector3f(0.0f, 0.0f, 1.0f), 100.0f));
+		EXPECT_TRUE(raytracer.ShadowRay(origin, maths::Vector3f(0.0f, 0.0f, 1.0f), direction, 5.0f));
+		EXPECT_FALSE(raytracer.ShadowRay(origin, maths::Vector3f(0.0f, 0.0f, 1.0f), direction));
+	}
+}
+
+// Test that sampling a few of many lights gives about the same light
+// as casting a shadow ray towards each of them
+TEST(Raytracing, Lights_SampledLikeExact)
+{
+	maths::Sphere sphere(6.0f, maths::Vector3f(0.0f, 0.0f, -16.0f));
+	std::vector<maths::Sphere> spheres{ sphere };
+	std::vector<Material> materials{ Material(0.0f, maths::Vector3f(255.0f, 255.0f, 255.0f)) };
+	std::vector<PointLight> lights;
+	for (int i = 0; i < 100; ++i)
+	{
+		PointLight light;
+		light.position = maths::Vector3f(0.01f * (i % 10), 0.01f * (i / 10), 0.0f);
+		light.intensity = 0.01f * (1 + i % 7);
+		lights.push_back(light);
+	}
+
+	Raytracer raytracer;
+	raytracer.SetScene(spheres, std::vector<maths::Plane>(), materials, PointLight(), 10, 10, 51.52f, 1e-4);
+	raytracer.SetLights(std::move(lights));
+	EXPECT_EQ(raytracer.lights().size(), 100u);
+	const maths::Vector3f origin(0.0f, 0.0f, 0.0f);
+	const maths::Vector3f direction(0.0f, 0.0f, -1.0f);
+
+	raytracer.set_light_sample_count(100);
+	const float exact = raytracer.RayCast(origin, direction).x;
+	raytracer.set_light_sample_count(4);
+	const float sampled = raytracer.RayCast(origin, direction).x;
+	EXPECT_GT(exact, 0.0f);
+	EXPECT_NEAR(sampled, exact, exact * 1e-3f);
+
+	//No sample count leaves the hits without light
+	for (const int light_sample_count : { 0, -3 })
+	{
+		raytracer.set_light_sample_count(light_sample_count);
+		EXPECT_EQ(raytracer.light_sample_count(), 1);
+		EXPECT_GT(raytracer.RayCast(origin, direction).x, 0.0f);
+	}
+}
+
+// Test that the triangles of a mesh are hit with their material,
+// and give the same image with and without the bvh
+TEST(Raytracing, Mesh_Intersect)
+{
+	TriangleMesh mesh;
+	mesh.vertices = { maths::Vector3f(-2.0f, -2.0f, -10.0f), maths::Vector3f(2.0f, -2.0f, -10.0f),
+		maths::Vector3f(2.0f, 2.0f, -10.0f), maths::Vector3f(-2.0f, 2.0f, -10.0f) };
+	mesh.indices = { 0, 1, 2, 0, 2, 3 };
+	maths::Sphere sphere(1.0f, maths::Vector3f(0.0f, 0.0f, -6.0f));
+	std::vector<maths::Sphere> spheres{ sphere };
+	std::vector<Material> materials{ Material(0.0f, maths::Vector3f(255.0f, 0.0f, 0.0f)) };
+
+	Raytracer raytracer;
+	raytracer.SetScene(spheres, std::vector<maths::Plane>(), materials, PointLight(), 20, 20, 51.52f, 1e-4);
+	raytracer.AddMesh(mesh, Material(0.0f, maths::Vector3f(0.0f, 255.0f, 0.0f)));
+	EXPECT_EQ(raytracer.triangles().triangle_count(), 2u);
+
+	//The sphere is in front of the mesh
+	maths::Ray3 center_ray(maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Vector3f(0.0f, 0.0f, -1.0f));
+	HitInfos hit_info;
+	float distance;
+	ASSERT_TRUE(raytracer.ObjectIntersect(center_ray, hit_info, distance));
+	EXPECT_FLOAT_EQ(distance, 5.0f);
+	maths::Ray3 mesh_ray(maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Vector3f(1.5f, 1.5f, -10.0f).Normalized());
+	ASSERT_TRUE(raytracer.ObjectIntersect(mesh_ray, hit_info, distance));
+	EXPECT_EQ(raytracer.materials()[hit_info.material_index].color(), maths::Vector3f(0.0f, 255.0f, 0.0f));
+	EXPECT_EQ(hit_info.normal, maths::Vector3f(0.0f, 0.0f, 1.0f));
+
+	raytracer.Render();
+	const std::vector<maths::Vector3f> bvh_image(raytracer.frameBuffer().begin(), raytracer.frameBuffer().end());
+	raytracer.set_acceleration(Acceleration::kBruteForce);
+	raytracer.set_render_mode(RenderMode::kPacket);
+	raytracer.Render();
+	for (std::size_t i = 0; i < bvh_image.size(); ++i)
+	{
+		EXPECT_EQ(bvh_image[i], raytracer.frameBuffer()[i]);
+	}
+
+	//A new scene has no mesh
+	raytracer.SetScene(spheres, std::vector<maths::Plane>(), materials, PointLight(), 20, 20, 51.52f, 1e-4);
+	EXPECT_FALSE(raytracer.ObjectIntersect(mesh_ray, hit_info, distance));
+}
+
+// Test that an instance of a model renders like the same sphere
+// placed in the scene, and follows its transform once updated
+TEST(Raytracing, Instances_SameImageAsSpheres)
+{
+	maths::Sphere sphere(2.0f, maths::Vector3f(1.0f, 0.0f, -10.0f));
+	std::vector<Material> materials{ Material(0.0f, maths::Vector3f(255.0f, 0.0f, 0.0f)) };
+	Raytracer reference;
+	reference.SetScene(std::vector<maths::Sphere>{ sphere }, std::vector<maths::Plane>(), materials, PointLight(), 20, 20, 51.52f, 1e-4);
+	reference.Render();
+
+	maths::Sphere unit_sphere(1.0f, maths::Vector3f(0.0f, 0.0f, 0.0f));
+	Raytracer raytracer;
+	raytracer.SetScene(std::vector<maths::Sphere>(), std::vector<maths::Plane>(), materials, PointLight(), 20, 20, 51.52f, 1e-4);
+	const std::uint32_t model = raytracer.AddModel(std::vector<maths::Sphere>{ unit_sphere });
+	//A model without triangles adds no material
+	EXPECT_EQ(raytracer.materials().size(), materials.size());
+	const maths::Matrix4f transform(
+		maths::Vector4f(2.0f, 0.0f, 0.0f, 0.0f),
+		maths::Vector4f(0.0f, 2.0f, 0.0f, 0.0f),
+		maths::Vector4f(0.0f, 0.0f, 2.0f, 0.0f),
+		maths::Vector4f(1.0f, 0.0f, -10.0f, 1.0f));
+	const std::uint32_t instance = raytracer.AddInstance(model, transform);
+	raytracer.Render();
+	for (std::size_t i = 0; i < reference.frameBuffer().size(); ++i)
+	{
+		EXPECT_NEAR(reference.frameBuffer()[i].x, raytracer.frameBuffer()[i].x, 1e-2f);
+		EXPECT_NEAR(reference.frameBuffer()[i].y, raytracer.frameBuffer()[i].y, 1e-2f);
+	}
+
+	//Move the instance out of the view
+	raytracer.SetInstanceTransform(instance, maths::Matrix4f::translationMatrix(maths::Vector3f(0.0f, 50.0f, -10.0f)));
+	raytracer.UpdateInstances();
+	maths::Ray3 ray(maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Vector3f(0.1f, 0.0f, -1.0f).Normalized());
+	HitInfos hit_info;
+	float distance;
+	EXPECT_FALSE(raytracer.ObjectIntersect(ray, hit_info, distance));
+	EXPECT_EQ(raytracer.instances().size(), 1u);
+}
+
+// Test that the closest plane is hit, whatever its place in the list,
+// and that a plane in front of a sphere hides it
+TEST(Raytracing, Planes_ClosestHit)
+{
+	std::vector<Material> materials{
+		Material(0.0f, maths::Vector3f(255.0f, 0.0f, 0.0f)),
+		Material(0.0f, maths::Vector3f(0.0f, 0.0f, 255.0f)),
+		Material(0.0f, maths::Vector3f(0.0f, 255.0f, 0.0f)),
+		Material(0.0f, maths::Vector3f(255.0f, 255.0f, 0.0f)) };
+	maths::Plane far_floor(maths::Vector3f(0.0f, -10.0f, 0.0f), maths::Vector3f(0.0f, 1.0f, 0.0f));
+	far_floor.set_material_index(1);
+	maths::Plane floor(maths::Vector3f(0.0f, -5.0f, 0.0f), maths::Vector3f(0.0f, 1.0f, 0.0f));
+	floor.set_material_index(2);
+	maths::Plane wall(maths::Vector3f(0.0f, 0.0f, -8.0f), maths::Vector3f(0.0f, 0.0f, 1.0f));
+	wall.set_material_index(3);
+	maths::Sphere sphere(1.0f, maths::Vector3f(0.0f, 0.0f, -10.0f));
+	std::vector<maths::Sphere> spheres{ sphere };
+
+	for (const Acceleration acceleration : { Acceleration::kBruteForce, Acceleration::kBvh })
+	{
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, std::vector<maths::Plane>{ far_floor, floor, wall }, materials,
+			PointLight(), 20, 20, 51.52f, 1e-4);
+		raytracer.set_acceleration(acceleration);
+		HitInfos hit_info;
+		float distance;
+
+		maths::Ray3 down(maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Vector3f(0.0f, -1.0f, 0.0f));
+		ASSERT_TRUE(raytracer.ObjectIntersect(down, hit_info, distance));
+		EXPECT_FLOAT_EQ(distance, 5.0f);
+		EXPECT_EQ(hit_info.material_index, floor.material_index());
+		EXPECT_EQ(hit_info.hit_position, maths::Vector3f(0.0f, -5.0f, 0.0f));
+
+		maths::Ray3 forward(maths::Vector3f(0.0f, 0.0f, 0.0f), maths::Vector3f(0.0f, 0.0f, -1.0f));
+		ASSERT_TRUE(raytracer.ObjectIntersect(forward, hit_info, distance));
+		EXPECT_FLOAT_EQ(distance, 8.0f);
+		EXPECT_EQ(hit_info.material_index, wall.material_index());
+	}
+
+	//Packets give the same image
+	Raytracer scalar;
+	scalar.SetScene(spheres, std::vector<maths::Plane>{ far_floor, floor }, materials, PointLight(), 20, 20, 51.52f, 1e-4);
+	scalar.Render();
+	Raytracer packet;
+	packet.SetScene(spheres, std::vector<maths::Plane>{ far_floor, floor }, materials, PointLight(), 20, 20, 51.52f, 1e-4);
+	packet.set_render_mode(RenderMode::kPacket);
+	packet.Render();
+	for (std::size_t i = 0; i < scalar.frameBuffer().size(); ++i)
+	{
+		EXPECT_EQ(scalar.frameBuffer()[i], packet.frameBuffer()[i]);
+	}
+}
+
+// Test that the samples of a pixel cover all of its cells once,
+// whether the sample count is square or not
+TEST(Raytracing, StratificationGrid_CoversPixelEvenly)
+{
+	for (int count = 1; count <= 64; ++count)
+	{
+		int columns;
+		int rows;
+		StratificationGrid(count, columns, rows);
+		ASSERT_EQ(columns * rows, count);
+		EXPECT_GE(columns, rows);
+		std::vector<int> samples_per_cell(count, 0);
+		for (int sample = 0; sample < count; ++sample)
+		{
+			const int column = sample % columns;
+			const int row = sample / columns;
+			ASSERT_LT(row, rows);
+			++samples_per_cell[column + row * columns];
+		}
+		EXPECT_EQ(samples_per_cell, std::vector<int>(count, 1));
+	}
+
+	//Five samples are five columns of the whole pixel height
+	int columns;
+	int rows;
+	StratificationGrid(5, columns, rows);
+	EXPECT_EQ(columns, 5);
+	EXPECT_EQ(rows, 1);
+	StratificationGrid(6, columns, rows);
+	EXPECT_EQ(columns, 3);
+	EXPECT_EQ(rows, 2);
+}
+
+// Test that supersampling gives the same image for any thread count,
+// tile size and render mode, and that only the seed changes the jitter
+TEST(Raytracing, Supersampling_Deterministic)
+{
+	int width = 30;
+	int heigth = 17;
+	maths::Sphere sphere(6.0f, maths::Vector3f(-2.0f, 0.0f, -16.0f));
+	std::vector<maths::Sphere> spheres{ sphere };
+	std::vector<Material> materials{ Material(0.2f, maths::Vector3f(255.0f, 0.0f, 0.0f)) };
+
+	auto render = [&](int samples, int threads, RenderMode mode, std::uint64_t seed)
+	{
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, std::vector<maths::Plane>(), materials, PointLight(), heigth, width, 51.52f, 1e-4);
+		raytracer.set_samples_per_pixel(samples);
+		raytracer.set_thread_count(threads);
+		raytracer.set_tile_size(threads == 1 ? 64 : 5);
+		raytracer.set_render_mode(mode);
+		raytracer.set_sample_seed(seed);
+		raytracer.Render();
+		const std::span<const maths::Vector3f> frame = raytracer.frameBuffer();
+		return std::vector<maths::Vector3f>(frame.begin(), frame.end());
+	};
+
+	//One sample is the ray through the center of the pixel, whatever the seed
+	EXPECT_EQ(render(1, 1, RenderMode::kScalar, 0), render(1, 1, RenderMode::kScalar, 7));
+
+	//Six samples do not fill the last packet
+	const std::vector<maths::Vector3f> reference = render(6, 1, RenderMode::kScalar, 3);
+	EXPECT_EQ(reference, render(6, 4, RenderMode::kScalar, 3));
+	EXPECT_EQ(reference, render(6, 3, RenderMode::kPacket, 3));
+	EXPECT_NE(reference, render(6, 1, RenderMode::kScalar, 4));
+
+	//The edge of the sphere is blended with the background
+	const std::vector<maths::Vector3f> center = render(1, 1, RenderMode::kScalar, 0);
+	int blended_pixels = 0;
+	for (std::size_t i = 0; i < reference.size(); ++i)
+	{
+		if (!(reference[i] == center[i]))
+		{
+			++blended_pixels;
+		}
+	}
+	EXPECT_GT(blended_pixels, 0);
+	EXPECT_LT(blended_pixels, width * heigth / 2);
+}
+
+// Test that the counters of a frame add up the tiles, and stay at zero
+// when the library is built without RAYTRACING_STATS
+TEST(Raytracing, RenderStats_Counters)
+{
+	int width = 24;
+	int heigth = 16;
+	maths::Sphere sphere(6.0f, maths::Vector3f(0.0f, 0.0f, -16.0f));
+	std::vector<maths::Sphere> spheres{ sphere };
+	std::vector<Material> materials{ Material(0.5f, maths::Vector3f(255.0f, 0.0f, 0.0f)) };
+
+	for (const RenderMode mode : { RenderMode::kScalar, RenderMode::kPacket })
+	{
+		Raytracer raytracer;
+		raytracer.SetScene(spheres, std::vector<maths::Plane>(), materials, PointLight(), heigth, width, 51.52f, 1e-4);
+		raytracer.set_thread_count(3);
+		raytracer.set_tile_size(5);
+		raytracer.set_render_mode(mode);
+		raytracer.Render();
+		const RenderStats& stats = raytracer.render_stats();
+		if constexpr (kRenderStatsEnabled)
+		{
+			EXPECT_EQ(stats.primary_rays, static_cast<std::uint64_t>(width * heigth));
+			//Every pixel seeing the sphere casts a shadow ray
+			EXPECT_GT(stats.shadow_rays, 0u);
+			EXPECT_LT(stats.shadow_rays, stats.primary_rays);
+			EXPECT_GT(stats.intersection_tests, 0u);
+			EXPECT_GT(stats.node_visits, 0u);
+			EXPECT_GT(stats.rays_per_second(), 0.0);
+
+			std::uint64_t tile_rays = 0;
+			for (const TileStats& tile : raytracer.tile_stats())
+			{
+				tile_rays += tile.counters.ray_count();
+			}
+			EXPECT_EQ(tile_rays, stats.ray_count());
+		}
+		else
+		{
+			EXPECT_EQ(stats.ray_count(), 0u);
+			EXPECT_EQ(stats.node_visits, 0u);
+		}
+	}
+}
+
 }// namespace raytracing
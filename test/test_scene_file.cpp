@@ -0,0 +1,250 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#include "raytracing/ray_tracer.h"
+#include "raytracing/scene_file.h"
+
+namespace raytracing {
+
+namespace {
+
+constexpr const char* kSceneText =
+	"# Two spheres on a floor\n"
+	"image 32 18\n"
+	"bias 0.001\n"
+	"camera 0.9 0 0 1 4 1 0 0 0 1 0 0 0 1\n"
+	"sphere -3 1 -12 3 0\n"
+	"sphere 4 0 -9 2 1\n"
+	"plane 0 -2 0 0 1 0 1\n"
+	"light 10 10 0\n"
+	"light -10 8 -4 0.5 20\n"
+	"material 0.2 255 0 0\n"
+	"material 0.0 0 0 255\n";
+
+}// namespace
+
+// Test that the text format fills every part of the scene
+TEST(SceneFile, ParseScene)
+{
+	SceneDescription scene;
+	ASSERT_TRUE(ParseScene(kSceneText, scene));
+	EXPECT_EQ(scene.width, 32);
+	EXPECT_EQ(scene.height, 18);
+	EXPECT_DOUBLE_EQ(scene.bias, 0.001);
+	EXPECT_FLOAT_EQ(scene.camera.fov().value(), 0.9f);
+	EXPECT_EQ(scene.camera.position(), maths::Vector3f(0.0f, 1.0f, 4.0f));
+	ASSERT_EQ(scene.spheres.size(), 2u);
+	EXPECT_EQ(scene.spheres.center(1), maths::Vector3f(4.0f, 0.0f, -9.0f));
+	EXPECT_EQ(scene.spheres.material_index[1], 1u);
+	ASSERT_EQ(scene.planes.size(), 1u);
+	EXPECT_EQ(scene.planes[0].normal, maths::Vector3f(0.0f, 1.0f, 0.0f));
+	ASSERT_EQ(scene.lights.size(), 2u);
+	EXPECT_FLOAT_EQ(scene.lights[1].falloff_radius, 20.0f);
+	ASSERT_EQ(scene.materials.size(), 2u);
+	EXPECT_FLOAT_EQ(scene.materials[0].reflexion_index(), 0.2f);
+
+	EXPECT_FALSE(ParseScene("sphere 0 0 -5 1\n", scene));
+	EXPECT_FALSE(ParseScene("material 0 1 1 1\nsphere 0 0 -5 1 1\n", scene));
+	EXPECT_FALSE(ParseScene("cube 0 0 0\n", scene));
+	EXPECT_FALSE(ParseScene("camera 1 0 0 0 0 1 0\n", scene));
+}
+
+// Test that a converted scene maps back to the same arrays, and renders
+// like the scene given to the raytracer directly
+TEST(SceneFile, ConvertAndLoad)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path();
+	const std::string text_path = (directory / "test_scene.txt").string();
+	const std::string binary_path = (directory / "test_scene.rtsc").string();
+	{
+		std::ofstream file(text_path);
+		file << kSceneText;
+	}
+	ASSERT_TRUE(ConvertSceneFile(text_path, binary_path));
+
+	SceneDescription scene;
+	ASSERT_TRUE(ParseScene(kSceneText, scene));
+	SceneFile scene_file;
+	ASSERT_TRUE(scene_file.Open(binary_path));
+	EXPECT_EQ(scene_file.width(), 32);
+	EXPECT_EQ(scene_file.height(), 18);
+	ASSERT_EQ(scene_file.sphere_radius().size(), 2u);
+	EXPECT_FLOAT_EQ(scene_file.sphere_radius()[0], 3.0f);
+	EXPECT_EQ(scene_file.sphere_material_index()[1], 1u);
+	EXPECT_EQ(scene_file.planes().size(), 1u);
+	EXPECT_EQ(scene_file.lights().size(), 2u);
+	EXPECT_FALSE(scene_file.bvh_nodes().empty());
+	EXPECT_EQ(scene_file.bvh_primitive_indices().size(), 2u);
+
+	Raytracer loaded;
+	loaded.SetScene(scene_file);
+	EXPECT_EQ(loaded.camera().position(), maths::Vector3f(0.0f, 1.0f, 4.0f));
+	EXPECT_EQ(loaded.lights().size(), 2u);
+	loaded.Render();
+
+	std::vector<maths::Plane> planes;
+	for (const ScenePlane& scene_plane : scene.planes)
+	{
+		maths::Plane plane(scene_plane.point, scene_plane.normal);
+		plane.set_material_index(scene_plane.material_index);
+		planes.push_back(plane);
+	}
+	std::vector<Material> materials = scene.materials;
+	Raytracer built;
+	built.SetScene(std::move(scene.spheres), std::move(materials), std::move(planes),
+		scene.lights[0], scene.height, scene.width, scene.camera.fov().value(), scene.bias);
+	built.SetLights(std::move(scene.lights));
+	built.set_camera(scene.camera);
+	built.Render();
+	for (std::size_t i = 0; i < built.frameBuffer().size(); ++i)
+	{
+		EXPECT_EQ(built.frameBuffer()[i], loaded.frameBuffer()[i]);
+	}
+	scene_file.Close();
+
+	//A file without lights renders without any, not with a default one
+	SceneDescription unlit;
+	ASSERT_TRUE(ParseScene(kSceneText, unlit));
+	unlit.lights.clear();
+	ASSERT_TRUE(WriteSceneFile(binary_path, unlit));
+	ASSERT_TRUE(scene_file.Open(binary_path));
+	loaded.SetScene(scene_file);
+	EXPECT_TRUE(loaded.lights().empty());
+	loaded.Render();
+	scene_file.Close();
+
+	//A file cut in the middle of its sections is refused
+	std::filesystem::resize_file(binary_path, sizeof(SceneFileHeader) + 8);
+	EXPECT_FALSE(scene_file.Open(binary_path));
+	EXPECT_FALSE(scene_file.is_open());
+	//So is a text file
+	EXPECT_FALSE(scene_file.Open(text_path));
+	std::filesystem::remove(text_path);
+	std::filesystem::remove(binary_path);
+}
+
+// Test that a file whose indices leave their arrays is refused, as the
+// text format refuses a material out of the table
+TEST(SceneFile, Open_RefusesBadIndices)
+{
+	SceneDescription scene;
+	ASSERT_TRUE(ParseScene(kSceneText, scene));
+	const std::string path = (std::filesystem::temp_directory_path() / "test_corrupt.rtsc").string();
+	ASSERT_TRUE(WriteSceneFile(path, scene));
+	std::vector<char> bytes(std::filesystem::file_size(path));
+	{
+		std::ifstream file(path, std::ios::binary);
+		file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+	SceneFileHeader header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+
+	//Write the file with one value changed, and try to open it
+	auto open_patched = [&](std::size_t file_offset, std::uint32_t value)
+	{
+		std::vector<char> corrupt = bytes;
+		std::memcpy(corrupt.data() + file_offset, &value, sizeof(value));
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(corrupt.data(), static_cast<std::streamsize>(corrupt.size()));
+		}
+		SceneFile scene_file;
+		return scene_file.Open(path);
+	};
+	auto open_with = [&](SceneSection section, std::size_t byte_offset, std::uint32_t value)
+	{
+		return open_patched(header.section_offsets[static_cast<std::size_t>(section)] + byte_offset, value);
+	};
+	EXPECT_TRUE(open_with(SceneSection::kSphereMaterial, 0, 1));
+	EXPECT_FALSE(open_with(SceneSection::kSphereMaterial, 0, 2));
+	EXPECT_FALSE(open_with(SceneSection::kPlanes, offsetof(ScenePlane, material_index), 7));
+	EXPECT_FALSE(open_with(SceneSection::kBvhIndices, sizeof(std::uint32_t), 2));
+	EXPECT_FALSE(open_with(SceneSection::kBvhNodes, offsetof(BvhNode, left_first), 100));
+
+	//Image sizes and lights that would not render
+	EXPECT_TRUE(open_patched(offsetof(SceneFileHeader, width), SceneFileHeader::kMaxImageSize));
+	EXPECT_FALSE(open_patched(offsetof(SceneFileHeader, width), 0));
+	EXPECT_FALSE(open_patched(offsetof(SceneFileHeader, height), 0x80000000u));
+	EXPECT_FALSE(open_patched(offsetof(SceneFileHeader, height), SceneFileHeader::kMaxImageSize + 1));
+	const std::size_t intensity = offsetof(SceneLightRecord, intensity);
+	const std::size_t falloff_radius = sizeof(SceneLightRecord) + offsetof(SceneLightRecord, falloff_radius);
+	EXPECT_FALSE(open_with(SceneSection::kLights, intensity, std::bit_cast<std::uint32_t>(0.0f)));
+	EXPECT_FALSE(open_with(SceneSection::kLights, intensity, std::bit_cast<std::uint32_t>(
+		std::numeric_limits<float>::quiet_NaN())));
+	EXPECT_FALSE(open_with(SceneSection::kLights, falloff_radius, std::bit_cast<std::uint32_t>(-20.0f)));
+	std::filesystem::remove(path);
+
+	SceneDescription parsed;
+	EXPECT_FALSE(ParseScene("image 0 10\n", parsed));
+	EXPECT_FALSE(ParseScene("image 100000 10\n", parsed));
+	EXPECT_FALSE(ParseScene("light 0 0 0 -1\n", parsed));
+	EXPECT_FALSE(ParseScene("light 0 0 0 1 0\n", parsed));
+	EXPECT_TRUE(ParseScene("light 0 0 0 2 5\n", parsed));
+}
+
+// Test that a hierarchy whose inner nodes share their children is
+// refused, as it could describe a tree far larger than the file
+TEST(SceneFile, Open_RefusesSharedChildren)
+{
+	SceneDescription scene;
+	ASSERT_TRUE(ParseScene(kSceneText, scene));
+	for (int i = 0; i < 40; ++i)
+	{
+		scene.spheres.push_back(maths::Vector3f(3.0f * i, 0.0f, -20.0f), 1.0f, 0);
+	}
+	const std::string path = (std::filesystem::temp_directory_path() / "test_shared.rtsc").string();
+	ASSERT_TRUE(WriteSceneFile(path, scene));
+	std::vector<char> bytes(std::filesystem::file_size(path));
+	{
+		std::ifstream file(path, std::ios::binary);
+		file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+	SceneFileHeader header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	BvhNode* nodes = reinterpret_cast<BvhNode*>(
+		bytes.data() + header.section_offsets[static_cast<std::size_t>(SceneSection::kBvhNodes)]);
+	ASSERT_FALSE(nodes[1].IsLeaf());
+	ASSERT_FALSE(nodes[2].IsLeaf());
+
+	//The two children of the root pointing at the same pair of nodes
+	nodes[2].left_first = nodes[1].left_first;
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+	SceneFile scene_file;
+	EXPECT_FALSE(scene_file.Open(path));
+	std::filesystem::remove(path);
+}
+
+}// namespace raytracing
@@ -0,0 +1,75 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace threading {
+
+// Test that every index is run exactly once whatever the number of threads
+TEST(ThreadPool, ParallelFor_RunsEachIndexOnce)
+{
+	for (std::size_t thread_count : { 1u, 2u, 4u, 8u })
+	{
+		ThreadPool pool(thread_count);
+		EXPECT_EQ(pool.thread_count(), thread_count);
+
+		std::vector<std::atomic<int>> calls(1000);
+		pool.ParallelFor(calls.size(), [&](std::size_t index)
+		{
+			calls[index]++;
+		});
+		for (const std::atomic<int>& call : calls)
+		{
+			EXPECT_EQ(call.load(), 1);
+		}
+	}
+}
+
+// Test that the pool can be reused for several batches of uneven tasks
+TEST(ThreadPool, ParallelFor_SeveralBatches)
+{
+	ThreadPool pool(4);
+	std::atomic<std::size_t> sum{ 0 };
+	for (int batch = 0; batch < 50; ++batch)
+	{
+		pool.ParallelFor(64, [&](std::size_t index)
+		{
+			// Only the first tasks are long, the other threads have to steal them
+			volatile std::size_t work = 0;
+			for (std::size_t i = 0; i < (index < 8 ? 10000u : 10u); ++i)
+			{
+				work = work + i;
+			}
+			sum += index;
+		});
+	}
+	EXPECT_EQ(sum.load(), 50u * (63u * 64u / 2u));
+}
+
+}// namespace threading
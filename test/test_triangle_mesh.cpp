@@ -0,0 +1,111 @@
+/*
+MIT License
+
+Copyright (c) 2021 SAE Institute Geneva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "raytracing/mapped_file.h"
+#include "raytracing/triangle_mesh.h"
+
+namespace raytracing {
+
+// Test that a triangle is only hit inside of it, in front
+// of the ray and closer than the given distance
+TEST(TriangleMesh, IntersectTriangle)
+{
+	const maths::Vector3f v0(-1.0f, -1.0f, -5.0f);
+	const maths::Vector3f v1(1.0f, -1.0f, -5.0f);
+	const maths::Vector3f v2(0.0f, 1.0f, -5.0f);
+	const maths::Vector3f origin(0.0f, 0.0f, 0.0f);
+
+	float distance = 100.0f;
+	EXPECT_TRUE(IntersectTriangle(v0, v1, v2, origin, maths::Vector3f(0.0f, 0.0f, -1.0f), distance));
+	EXPECT_FLOAT_EQ(distance, 5.0f);
+	//Seen from the back
+	distance = 100.0f;
+	EXPECT_TRUE(IntersectTriangle(v0, v2, v1, origin, maths::Vector3f(0.0f, 0.0f, -1.0f), distance));
+	//A closer hit is already known
+	distance = 4.0f;
+	EXPECT_FALSE(IntersectTriangle(v0, v1, v2, origin, maths::Vector3f(0.0f, 0.0f, -1.0f), distance));
+	//Behind the ray
+	distance = 100.0f;
+	EXPECT_FALSE(IntersectTriangle(v0, v1, v2, origin, maths::Vector3f(0.0f, 0.0f, 1.0f), distance));
+	//Outside of the triangle
+	EXPECT_FALSE(IntersectTriangle(v0, v1, v2, origin, maths::Vector3f(0.5f, 0.9f, -5.0f).Normalized(), distance));
+	//Parallel to the triangle
+	EXPECT_FALSE(IntersectTriangle(v0, v1, v2, origin, maths::Vector3f(1.0f, 0.0f, 0.0f), distance));
+}
+
+TEST(TriangleMesh, ParseObj)
+{
+	TriangleMesh mesh;
+	ASSERT_TRUE(ParseObj(
+		"# a quad and a triangle\r\n"
+		"o quad\n"
+		"v -1 -1 0\n"
+		"v 1 -1 0\n"
+		"v 1 1 0\n"
+		"v -1 1.5e0 0\n"
+		"vn 0 0 1\n"
+		"f 1//1 2//1 3//1 4//1\n"
+		"f -4/1 -3/2/1 -1\n", mesh));
+	ASSERT_EQ(mesh.vertices.size(), 4u);
+	EXPECT_EQ(mesh.vertices[3], maths::Vector3f(-1.0f, 1.5f, 0.0f));
+	ASSERT_EQ(mesh.triangle_count(), 3u);
+	const std::vector<std::uint32_t> expected_indices{ 0, 1, 2, 0, 2, 3, 0, 1, 3 };
+	EXPECT_EQ(mesh.indices, expected_indices);
+	EXPECT_EQ(mesh.normal(0), maths::Vector3f(0.0f, 0.0f, 1.0f));
+
+	EXPECT_FALSE(ParseObj("v 1 2\n", mesh));
+	EXPECT_FALSE(ParseObj("v 0 0 0\nv 1 0 0\nf 1 2\n", mesh));
+	EXPECT_FALSE(ParseObj("v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n", mesh));
+}
+
+// Test that a mesh is read the same way through a mapped file
+TEST(TriangleMesh, LoadObj)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "test_mesh.obj").string();
+	{
+		std::ofstream file(path);
+		file << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3";
+	}
+	TriangleMesh mesh;
+	ASSERT_TRUE(LoadObj(path, mesh));
+	EXPECT_EQ(mesh.triangle_count(), 1u);
+
+	MappedFile file;
+	ASSERT_TRUE(file.Open(path));
+	EXPECT_EQ(file.view().substr(0, 7), "v 0 0 0");
+	MappedFile moved = std::move(file);
+	EXPECT_FALSE(file.is_open());
+	EXPECT_TRUE(moved.is_open());
+	moved.Close();
+	std::filesystem::remove(path);
+
+	EXPECT_FALSE(LoadObj(path, mesh));
+}
+
+}// namespace raytracing